@@ -0,0 +1,541 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+/*
+ * Headless replayer for motion filter record files (see motion-record.h).
+ * The filter source is compiled in as-is and re-driven through
+ * motion_init and motion_filter_tick against the libobs stand-in:
+ *
+ *   filter-replay <record file>
+ *
+ * Every recorded tick is checked bit-for-bit against the item channels
+ * the replay commits, and timings for the recording and the replay are
+ * printed as JSON on stdout. Exits with 1 on any mismatch, 2 if the file
+ * cannot be read.
+ */
+
+#include "obs-standin.h"
+#include "../src/motion-filter/motion-filter.c"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define REPLAY_CHANNELS (VARIATION_ALWAYS | VARIATION_ROTATION | \
+	VARIATION_BOUNDS | VARIATION_CROP)
+
+struct replay_filter {
+	struct replay_filter  *next;
+	uint32_t              id;
+	obs_scene_t           *scene;
+	obs_source_t          *context;
+	obs_source_t          *item_source;
+	obs_sceneitem_t       *item;
+	obs_data_t            *settings;
+	motion_filter_data_t  *filter;
+};
+
+struct reader {
+	const uint8_t       *data;
+	size_t              size;
+	size_t              pos;
+	bool                error;
+};
+
+struct timing {
+	uint64_t            count;
+	uint64_t            sum;
+	uint64_t            max;
+};
+
+struct replay {
+	struct replay_filter  *filters;
+	size_t                num_filters;
+	size_t                records;
+	size_t                triggers;
+	size_t                trigger_mismatches;
+	size_t                ticks;
+	size_t                tick_mismatches;
+	size_t                external_changes;
+	size_t                unknown_records;
+	uint64_t              first_ts;
+	uint64_t              last_ts;
+	struct timing         recorded_tick;
+	struct timing         replay_tick;
+	struct timing         replay_trigger;
+	bool                  has_mismatch;
+	size_t                mismatch_record;
+	uint32_t              mismatch_filter;
+	float                 expected[CHANNEL_COUNT];
+	float                 actual[CHANNEL_COUNT];
+};
+
+/* ------------------------------------------------------------------------- */
+/* reading */
+
+static uint64_t get_uint(struct reader *r, size_t size)
+{
+	uint64_t value = 0;
+
+	if (r->error || r->pos + size > r->size) {
+		r->error = true;
+		return 0;
+	}
+
+	for (size_t i = 0; i < size; i++)
+		value |= (uint64_t)r->data[r->pos + i] << (i * 8);
+	r->pos += size;
+	return value;
+}
+
+static inline uint8_t get_u8(struct reader *r)   { return (uint8_t)get_uint(r, 1); }
+static inline uint16_t get_u16(struct reader *r) { return (uint16_t)get_uint(r, 2); }
+static inline uint32_t get_u32(struct reader *r) { return (uint32_t)get_uint(r, 4); }
+static inline uint64_t get_u64(struct reader *r) { return get_uint(r, 8); }
+
+static float get_f32(struct reader *r)
+{
+	uint32_t bits = get_u32(r);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static double get_f64(struct reader *r)
+{
+	uint64_t bits = get_u64(r);
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+/* returns a bmalloc'd copy */
+static char *get_str(struct reader *r)
+{
+	size_t len = get_u16(r);
+	char *str;
+
+	if (r->error || r->pos + len > r->size) {
+		r->error = true;
+		return NULL;
+	}
+
+	str = bmalloc(len + 1);
+	memcpy(str, r->data + r->pos, len);
+	str[len] = 0;
+	r->pos += len;
+	return str;
+}
+
+/* channels the recording has no value for are left at zero */
+static void get_values(struct reader *r, float *values, size_t *num_values)
+{
+	size_t count = get_u8(r);
+
+	memset(values, 0, sizeof(float) * CHANNEL_COUNT);
+	for (size_t i = 0; i < count && !r->error; i++) {
+		float value = get_f32(r);
+		if (i < CHANNEL_COUNT)
+			values[i] = value;
+	}
+
+	if (num_values)
+		*num_values = count < CHANNEL_COUNT ? count : CHANNEL_COUNT;
+}
+
+static uint8_t *read_file(const char *path, size_t *size)
+{
+	FILE *file = fopen(path, "rb");
+	uint8_t *data = NULL;
+	long len;
+
+	if (!file)
+		return NULL;
+
+	if (fseek(file, 0, SEEK_END) == 0 && (len = ftell(file)) >= 0 &&
+			fseek(file, 0, SEEK_SET) == 0) {
+		data = bmalloc((size_t)len + 1);
+		*size = fread(data, 1, (size_t)len, file);
+	}
+
+	fclose(file);
+	return data;
+}
+
+/* ------------------------------------------------------------------------- */
+/* replay */
+
+static void add_timing(struct timing *timing, uint64_t value)
+{
+	timing->count++;
+	timing->sum += value;
+	if (value > timing->max)
+		timing->max = value;
+}
+
+static struct replay_filter *find_filter(struct replay *replay, uint32_t id)
+{
+	struct replay_filter *rf;
+
+	for (rf = replay->filters; rf; rf = rf->next) {
+		if (rf->id == id)
+			return rf;
+	}
+
+	return NULL;
+}
+
+/* libobs runs a pending update on the video tick, before the filter ticks */
+static void run_pending_update(struct replay_filter *rf)
+{
+	if (standin_source_take_update(rf->context))
+		motion_filter_update(rf->filter, rf->settings);
+}
+
+static bool read_settings(struct reader *r, obs_data_t *settings)
+{
+	size_t count = get_u16(r);
+
+	for (size_t i = 0; i < count && !r->error; i++) {
+		uint8_t type = get_u8(r);
+		char *key = get_str(r);
+		char *str;
+
+		switch (type) {
+		case RECORD_INT:
+			obs_data_set_int(settings, key, (long long)get_u64(r));
+			break;
+		case RECORD_DOUBLE:
+			obs_data_set_double(settings, key, get_f64(r));
+			break;
+		case RECORD_BOOL:
+			obs_data_set_bool(settings, key, get_u8(r) != 0);
+			break;
+		case RECORD_STRING:
+			str = get_str(r);
+			obs_data_set_string(settings, key, str);
+			bfree(str);
+			break;
+		default:
+			r->error = true;
+		}
+
+		bfree(key);
+	}
+
+	return !r->error;
+}
+
+static bool replay_filter_record(struct replay *replay, uint32_t id,
+	struct reader *r)
+{
+	struct replay_filter *rf = find_filter(replay, id);
+	char *name = get_str(r);
+	bool success;
+
+	if (rf) {
+		success = read_settings(r, rf->settings);
+		obs_source_update(rf->context, rf->settings);
+		bfree(name);
+		return success;
+	}
+
+	rf = bzalloc(sizeof(*rf));
+	rf->id = id;
+	rf->settings = obs_data_create();
+	motion_filter_defaults(rf->settings);
+	success = read_settings(r, rf->settings);
+
+	rf->scene = standin_scene_create();
+	rf->context = standin_filter_create(standin_scene_source(rf->scene,
+		obs_data_get_string(rf->settings, S_SCENE_NAME)), name,
+		rf->settings);
+
+	/* the recording was made after create and the first update */
+	rf->filter = motion_filter_create(rf->settings, rf->context);
+	run_pending_update(rf);
+
+	/* hotkeys and frontend callbacks are replaced by the record itself */
+	rf->filter->initialize = true;
+
+	rf->next = replay->filters;
+	replay->filters = rf;
+	replay->num_filters++;
+	bfree(name);
+	return success;
+}
+
+/* brings the item to the state it had when the trigger fired */
+static void restore_item(struct replay *replay, struct replay_filter *rf,
+	const struct motion_record_item *rec)
+{
+	struct obs_transform_info info;
+	float current[CHANNEL_COUNT];
+
+	if (!rec->found)
+		return;
+
+	if (!rf->item) {
+		memset(&info, 0, sizeof(info));
+		rf->item_source = standin_source_create(
+			obs_data_get_string(rf->settings, S_SOURCE),
+			rec->width, rec->height);
+		rf->item = standin_scene_add(rf->scene, rf->item_source, &info);
+		set_item_channels(rf->item, rec->values, REPLAY_CHANNELS);
+		return;
+	}
+
+	get_item_channels(rf->item, current);
+	if (memcmp(current, rec->values, sizeof(current)) != 0 ||
+			obs_source_get_width(rf->item_source) != rec->width ||
+			obs_source_get_height(rf->item_source) != rec->height) {
+		set_item_channels(rf->item, rec->values, REPLAY_CHANNELS);
+		standin_source_set_size(rf->item_source, rec->width,
+			rec->height);
+		replay->external_changes++;
+	}
+}
+
+static void replay_trigger_record(struct replay *replay,
+	struct replay_filter *rf, struct reader *r)
+{
+	struct motion_record_item rec = { 0 };
+	enum motion_trigger trigger = (enum motion_trigger)get_u8(r);
+	bool forward = get_u8(r) != 0;
+	bool started = get_u8(r) != 0;
+	bool replay_started = false;
+	uint64_t start;
+
+	rec.found = get_u8(r) != 0;
+	rec.width = get_u32(r);
+	rec.height = get_u32(r);
+	get_values(r, rec.values, &rec.num_values);
+
+	if (r->error)
+		return;
+
+	restore_item(replay, rf, &rec);
+	replay->triggers++;
+
+	start = os_gettime_ns();
+	if (trigger == TRIGGER_SCENE_LEAVE)
+		leave_scene(rf->filter);
+	else
+		replay_started = motion_init(rf->filter, forward);
+	add_timing(&replay->replay_trigger, os_gettime_ns() - start);
+
+	if (trigger != TRIGGER_SCENE_LEAVE && replay_started != started)
+		replay->trigger_mismatches++;
+}
+
+static void replay_tick_record(struct replay *replay,
+	struct replay_filter *rf, struct reader *r)
+{
+	float seconds = get_f32(r);
+	float expected[CHANNEL_COUNT];
+	float actual[CHANNEL_COUNT];
+	bool moving;
+	uint64_t start;
+
+	add_timing(&replay->recorded_tick, get_u32(r));
+	get_values(r, expected, NULL);
+
+	if (r->error)
+		return;
+
+	run_pending_update(rf);
+	moving = rf->filter->motion_start;
+	replay->ticks++;
+
+	start = os_gettime_ns();
+	motion_filter_tick(rf->filter, seconds);
+	add_timing(&replay->replay_tick, os_gettime_ns() - start);
+
+	memset(actual, 0, sizeof(actual));
+	if (rf->item)
+		get_item_channels(rf->item, actual);
+
+	if (moving && rf->item && memcmp(expected, actual, sizeof(actual)) == 0)
+		return;
+
+	replay->tick_mismatches++;
+	if (!replay->has_mismatch) {
+		replay->has_mismatch = true;
+		replay->mismatch_record = replay->records;
+		replay->mismatch_filter = rf->id;
+		memcpy(replay->expected, expected, sizeof(expected));
+		memcpy(replay->actual, actual, sizeof(actual));
+	}
+}
+
+static bool replay_record(struct replay *replay, struct reader *r)
+{
+	uint8_t type = get_u8(r);
+	uint32_t id = get_u32(r);
+	uint64_t ts = get_u64(r);
+	uint32_t size = get_u32(r);
+	struct reader payload;
+	struct replay_filter *rf;
+
+	if (r->error || r->pos + size > r->size)
+		return false;
+
+	payload.data = r->data + r->pos;
+	payload.size = size;
+	payload.pos = 0;
+	payload.error = false;
+	r->pos += size;
+
+	if (!replay->first_ts)
+		replay->first_ts = ts;
+	replay->last_ts = ts;
+
+	if (type == RECORD_FILTER)
+		return replay_filter_record(replay, id, &payload);
+
+	rf = find_filter(replay, id);
+	if (!rf || (type != RECORD_TRIGGER && type != RECORD_TICK)) {
+		replay->unknown_records++;
+		return true;
+	}
+
+	if (type == RECORD_TRIGGER)
+		replay_trigger_record(replay, rf, &payload);
+	else
+		replay_tick_record(replay, rf, &payload);
+
+	return !payload.error;
+}
+
+static void free_replay(struct replay *replay)
+{
+	struct replay_filter *rf = replay->filters;
+
+	while (rf) {
+		struct replay_filter *next = rf->next;
+		motion_filter_destroy(rf->filter);
+		standin_source_destroy(rf->context);
+		standin_scene_destroy(rf->scene);
+		standin_source_destroy(rf->item_source);
+		obs_data_release(rf->settings);
+		bfree(rf);
+		rf = next;
+	}
+}
+
+static void print_timing(const char *name, const struct timing *timing,
+	bool last)
+{
+	printf("\t\t\"%s\": {\"count\": %llu, \"mean\": %llu, \"max\": %llu}%s\n",
+		name, (unsigned long long)timing->count,
+		(unsigned long long)(timing->count ?
+			timing->sum / timing->count : 0),
+		(unsigned long long)timing->max, last ? "" : ",");
+}
+
+static void print_values(const char *name, const float *values, bool last)
+{
+	printf("\"%s\": [", name);
+	for (size_t i = 0; i < CHANNEL_COUNT; i++)
+		printf("%s%.9g", i ? ", " : "", values[i]);
+	printf("]%s", last ? "" : ", ");
+}
+
+static void print_report(const char *path, struct replay *replay,
+	uint64_t replay_ns, bool complete)
+{
+	printf("{\n\t\"file\": \"%s\",\n\t\"complete\": %s,\n"
+		"\t\"records\": %zu,\n\t\"filters\": %zu,\n"
+		"\t\"triggers\": %zu,\n\t\"trigger_mismatches\": %zu,\n"
+		"\t\"ticks\": %zu,\n\t\"tick_mismatches\": %zu,\n"
+		"\t\"external_changes\": %zu,\n\t\"unknown_records\": %zu,\n"
+		"\t\"recorded_ms\": %.3f,\n\t\"replay_ms\": %.3f,\n",
+		path, complete ? "true" : "false", replay->records,
+		replay->num_filters, replay->triggers,
+		replay->trigger_mismatches, replay->ticks,
+		replay->tick_mismatches, replay->external_changes,
+		replay->unknown_records,
+		(replay->last_ts - replay->first_ts) / 1000000.0,
+		replay_ns / 1000000.0);
+
+	printf("\t\"timing_ns\": {\n");
+	print_timing("recorded_tick", &replay->recorded_tick, false);
+	print_timing("replay_tick", &replay->replay_tick, false);
+	print_timing("replay_trigger", &replay->replay_trigger, true);
+	printf("\t}");
+
+	if (replay->has_mismatch) {
+		printf(",\n\t\"first_mismatch\": {\"record\": %zu, "
+			"\"filter\": %u, ", replay->mismatch_record,
+			replay->mismatch_filter);
+		print_values("expected", replay->expected, false);
+		print_values("actual", replay->actual, true);
+		printf("}");
+	}
+
+	printf("\n}\n");
+}
+
+int main(int argc, char **argv)
+{
+	struct replay replay;
+	struct reader r = { 0 };
+	uint8_t *data;
+	uint64_t start;
+	bool complete = true;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <record file>\n", argv[0]);
+		return 2;
+	}
+
+	data = read_file(argv[1], &r.size);
+	r.data = data;
+	if (!data || r.size < 8 || memcmp(data, MOTION_RECORD_MAGIC, 4) != 0) {
+		fprintf(stderr, "%s: not a motion record file\n", argv[1]);
+		bfree(data);
+		return 2;
+	}
+
+	r.pos = 4;
+	if (get_u32(&r) != MOTION_RECORD_VERSION) {
+		fprintf(stderr, "%s: unsupported version\n", argv[1]);
+		bfree(data);
+		return 2;
+	}
+
+	memset(&replay, 0, sizeof(replay));
+	start = os_gettime_ns();
+
+	while (r.pos < r.size) {
+		if (!replay_record(&replay, &r)) {
+			/* a crash can leave a partial record at the end */
+			complete = false;
+			break;
+		}
+		replay.records++;
+	}
+
+	print_report(argv[1], &replay, os_gettime_ns() - start, complete);
+
+	free_replay(&replay);
+	bfree(data);
+
+	return replay.trigger_mismatches || replay.tick_mismatches ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+/*
+ * Geometry checks for the transform helpers the transitions rely on,
+ * against hand-computed results. Runs from ctest, or on its own:
+ *
+ *   geometry-test
+ *
+ * Prints each failing case to stderr and exits with 1 if any failed. The
+ * plan source is #included for its static parent mapping.
+ */
+
+#include "obs-standin.h"
+#include "../src/motion-transition/transition-plan.c"
+#include <math.h>
+#include <stdio.h>
+
+struct bbox_case {
+	const char          *name;
+	float               pos_x;
+	float               scale_x;
+	uint32_t            alignment;
+	enum obs_bounds_type bounds_type;
+	uint32_t            bounds_alignment;
+	float               min_x;
+	float               max_x;
+};
+
+/* a 1920x1080 source, unrotated, at y 0 */
+static const struct bbox_case bbox_cases[] = {
+	{"plain", 0.0f, 1.0f, OBS_ALIGN_TOP | OBS_ALIGN_LEFT,
+		OBS_BOUNDS_NONE, 0, 0.0f, 1920.0f},
+	{"flipped", 1920.0f, -1.0f, OBS_ALIGN_TOP | OBS_ALIGN_LEFT,
+		OBS_BOUNDS_NONE, 0, 0.0f, 1920.0f},
+	{"flipped centered", 960.0f, -0.5f, OBS_ALIGN_TOP,
+		OBS_BOUNDS_NONE, 0, 480.0f, 1440.0f},
+	{"outer, right aligned", 1000.0f, 1.0f, OBS_ALIGN_TOP | OBS_ALIGN_LEFT,
+		OBS_BOUNDS_SCALE_OUTER, OBS_ALIGN_TOP | OBS_ALIGN_RIGHT,
+		1000.0f - 1920.0f * 1000.0f / 1080.0f + 1000.0f, 2000.0f},
+};
+
+static bool check_item_bbox(void)
+{
+	struct obs_sceneitem_crop crop = {0};
+	bool ok = true;
+
+	for (size_t i = 0; i < sizeof(bbox_cases) / sizeof(bbox_cases[0]);
+			i++) {
+		const struct bbox_case *c = &bbox_cases[i];
+		struct obs_transform_info info = {0};
+		struct vec2 min, max;
+
+		info.pos.x = c->pos_x;
+		info.scale.x = c->scale_x;
+		info.scale.y = fabsf(c->scale_x);
+		info.alignment = c->alignment;
+		info.bounds_type = c->bounds_type;
+		info.bounds_alignment = c->bounds_alignment;
+		vec2_set(&info.bounds, 1000.0f, 1000.0f);
+
+		if (!get_item_bbox(&info, &crop, 1920.0f, 1080.0f, &min,
+				&max) || fabsf(min.x - c->min_x) > 0.01f ||
+				fabsf(max.x - c->max_x) > 0.01f) {
+			fprintf(stderr, "bbox '%s': expected x %.2f..%.2f\n",
+				c->name, c->min_x, c->max_x);
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+struct parent_case {
+	const char          *name;
+	float               rot;
+	float               scale_x;
+	float               scale_y;
+};
+
+/* a 400x200 group at 500,300 around a 100x80 child turned by 20 degrees */
+static const struct parent_case parent_cases[] = {
+	{"plain", 30.0f, 2.0f, 2.0f},
+	{"mirrored x", 30.0f, -1.0f, 1.0f},
+	{"mirrored y", -45.0f, 1.5f, -1.5f},
+	{"turned over", 120.0f, -1.0f, -1.0f},
+};
+
+static bool same_matrix(const struct matrix4 *a, const struct matrix4 *b)
+{
+	return fabsf(a->x.x - b->x.x) < 0.001f &&
+		fabsf(a->x.y - b->x.y) < 0.001f &&
+		fabsf(a->y.x - b->y.x) < 0.001f &&
+		fabsf(a->y.y - b->y.y) < 0.001f &&
+		fabsf(a->t.x - b->t.x) < 0.01f &&
+		fabsf(a->t.y - b->t.y) < 0.01f;
+}
+
+static inline float angle_diff(float a, float b)
+{
+	float diff = fmodf(fabsf(a - b), 360.0f);
+	return diff > 180.0f ? 360.0f - diff : diff;
+}
+
+/*
+ * Maps a child through a group and back: the canvas transform from
+ * to_world has to draw where libobs draws the child inside the group, and
+ * to_local has to give the child back.
+ */
+static bool check_parent_mapping(void)
+{
+	bool ok = true;
+
+	for (size_t i = 0;
+			i < sizeof(parent_cases) / sizeof(parent_cases[0]);
+			i++) {
+		const struct parent_case *c = &parent_cases[i];
+		struct obs_transform_info group = {0}, child = {0};
+		struct obs_transform_info world, local;
+		struct matrix4 group_m, child_m, expected, actual;
+		item_parent_t parent;
+
+		vec2_set(&group.pos, 500.0f, 300.0f);
+		vec2_set(&group.scale, c->scale_x, c->scale_y);
+		group.rot = c->rot;
+		vec2_set(&child.pos, 50.0f, 40.0f);
+		vec2_set(&child.scale, 1.5f, 1.5f);
+		child.rot = 20.0f;
+
+		get_item_draw_transform(&group, 400.0f, 200.0f, &group_m);
+		get_item_draw_transform(&child, 100.0f, 80.0f, &child_m);
+		matrix4_mul(&expected, &child_m, &group_m);
+
+		memset(&parent, 0, sizeof(parent));
+		set_parent_transform(&parent, &group_m);
+		to_world(&parent, &child, &world);
+		get_item_draw_transform(&world, 100.0f, 80.0f, &actual);
+
+		if (!same_matrix(&expected, &actual) ||
+				!to_local(&parent, &world, &local) ||
+				angle_diff(local.rot, child.rot) > 0.01f ||
+				fabsf(local.pos.x - child.pos.x) > 0.01f ||
+				fabsf(local.pos.y - child.pos.y) > 0.01f) {
+			fprintf(stderr, "parent '%s': child drawn at %.2f "
+				"degrees, or not mapped back\n", c->name,
+				world.rot);
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+int main(void)
+{
+	bool ok = check_item_bbox();
+	ok = check_parent_mapping() && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,407 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+/*
+ * Command line client for the control socket (see src/motion-control.h):
+ *
+ *   motion-ctl [--socket PATH] list
+ *   motion-ctl [--socket PATH] trigger <source> <filter> [--backward]
+ *              [--offset SECONDS] [--repeat N]
+ *   motion-ctl [--socket PATH] query <source> [<filter>]
+ *   motion-ctl [--socket PATH] latency
+ *
+ * The socket path defaults to $MOTION_EFFECT_CONTROL. With --repeat the
+ * trigger is sent N times, one request in flight at a time, and the round
+ * trip times are printed; each reply comes back once the trigger is queued,
+ * so this measures the socket path only. The 'latency' command reports
+ * the plugin's queue-to-frame latency for everything triggered so far.
+ */
+
+#include "../src/motion-control.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CONTROL_ENV "MOTION_EFFECT_CONTROL"
+
+struct buffer {
+	uint8_t             data[4 + CONTROL_MAX_MESSAGE];
+	size_t              size;
+	size_t              pos;
+};
+
+static uint32_t next_tag = 1;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static bool put_uint(struct buffer *buf, uint64_t value, size_t size)
+{
+	if (buf->size + size > sizeof(buf->data))
+		return false;
+
+	for (size_t i = 0; i < size; i++)
+		buf->data[buf->size++] = (uint8_t)(value >> (i * 8));
+	return true;
+}
+
+static bool put_f32(struct buffer *buf, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return put_uint(buf, bits, 4);
+}
+
+static bool put_str(struct buffer *buf, const char *str)
+{
+	size_t len = strlen(str);
+
+	if (len > 0xFFFF || !put_uint(buf, len, 2) ||
+			buf->size + len > sizeof(buf->data))
+		return false;
+
+	memcpy(buf->data + buf->size, str, len);
+	buf->size += len;
+	return true;
+}
+
+static uint64_t get_uint(struct buffer *buf, size_t size)
+{
+	uint64_t value = 0;
+
+	if (buf->pos + size > buf->size) {
+		buf->pos = buf->size + 1;
+		return 0;
+	}
+
+	for (size_t i = 0; i < size; i++)
+		value |= (uint64_t)buf->data[buf->pos + i] << (i * 8);
+	buf->pos += size;
+	return value;
+}
+
+static float get_f32(struct buffer *buf)
+{
+	uint32_t bits = (uint32_t)get_uint(buf, 4);
+	float value;
+
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static void print_str(struct buffer *buf)
+{
+	size_t len = (size_t)get_uint(buf, 2);
+
+	if (buf->pos + len > buf->size) {
+		buf->pos = buf->size + 1;
+		return;
+	}
+
+	printf("%.*s", (int)len, (const char *)buf->data + buf->pos);
+	buf->pos += len;
+}
+
+static inline bool truncated(const struct buffer *buf)
+{
+	return buf->pos > buf->size;
+}
+
+static void begin(struct buffer *buf, enum control_op op)
+{
+	buf->size = 0;
+	put_uint(buf, 0, 4);
+	put_uint(buf, op, 1);
+	put_uint(buf, next_tag++, 4);
+}
+
+static bool io_all(int fd, uint8_t *data, size_t size, bool sending)
+{
+	while (size) {
+		ssize_t n = sending ? send(fd, data, size, 0) :
+			recv(fd, data, size, 0);
+
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+
+		data += n;
+		size -= (size_t)n;
+	}
+
+	return true;
+}
+
+/* sends the request in 'buf' and replaces it with the reply payload */
+static bool transact(int fd, struct buffer *buf)
+{
+	uint32_t tag = (uint32_t)(buf->data[5] | buf->data[6] << 8 |
+		buf->data[7] << 16 | (uint32_t)buf->data[8] << 24);
+	size_t len = buf->size - 4;
+	uint8_t status;
+
+	for (size_t i = 0; i < 4; i++)
+		buf->data[i] = (uint8_t)(len >> (i * 8));
+
+	if (!io_all(fd, buf->data, buf->size, true) ||
+			!io_all(fd, buf->data, 4, false)) {
+		fprintf(stderr, "connection lost\n");
+		return false;
+	}
+
+	len = buf->data[0] | buf->data[1] << 8 | buf->data[2] << 16 |
+		(size_t)buf->data[3] << 24;
+	if (len < 5 || len > CONTROL_MAX_MESSAGE ||
+			!io_all(fd, buf->data + 4, len, false)) {
+		fprintf(stderr, "invalid reply\n");
+		return false;
+	}
+
+	buf->size = 4 + len;
+	buf->pos = 4;
+	status = (uint8_t)get_uint(buf, 1);
+
+	if (get_uint(buf, 4) != tag) {
+		fprintf(stderr, "reply tag mismatch\n");
+		return false;
+	}
+	if (status != CONTROL_OK) {
+		fprintf(stderr, "request failed\n");
+		return false;
+	}
+
+	return true;
+}
+
+static int connect_socket(const char *path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	memset(&addr, 0, sizeof(addr));
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "%s: path too long\n", path);
+		return -1;
+	}
+
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr *)&addr,
+			sizeof(addr)) != 0) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		if (fd >= 0)
+			close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+static bool list(int fd, struct buffer *buf)
+{
+	size_t count;
+
+	begin(buf, CONTROL_LIST);
+	if (!transact(fd, buf))
+		return false;
+
+	count = (size_t)get_uint(buf, 2);
+	for (size_t i = 0; i < count && !truncated(buf); i++) {
+		bool transition = get_uint(buf, 1) == CONTROL_KIND_TRANSITION;
+
+		printf("%s\t", transition ? "transition" : "filter");
+		print_str(buf);
+		printf("\t");
+		print_str(buf);
+		printf("\n");
+	}
+
+	return !truncated(buf);
+}
+
+static bool trigger(int fd, struct buffer *buf, const char *source,
+	const char *filter, bool forward, float offset, size_t repeat)
+{
+	uint64_t min = UINT64_MAX, max = 0, total = 0;
+
+	for (size_t i = 0; i < repeat; i++) {
+		uint64_t start, elapsed;
+
+		begin(buf, CONTROL_TRIGGER);
+		if (!put_str(buf, source) || !put_str(buf, filter) ||
+				!put_uint(buf, forward, 1) ||
+				!put_f32(buf, offset)) {
+			fprintf(stderr, "names too long\n");
+			return false;
+		}
+
+		start = now_ns();
+		if (!transact(fd, buf))
+			return false;
+
+		elapsed = now_ns() - start;
+		total += elapsed;
+		if (elapsed < min)
+			min = elapsed;
+		if (elapsed > max)
+			max = elapsed;
+	}
+
+	if (repeat > 1)
+		printf("%zu round trips, min %.3f ms, mean %.3f ms, "
+			"max %.3f ms\n", repeat, min / 1000000.0,
+			total / repeat / 1000000.0, max / 1000000.0);
+	return true;
+}
+
+static bool query(int fd, struct buffer *buf, const char *source,
+	const char *filter)
+{
+	bool running, at_end;
+	float progress;
+
+	begin(buf, CONTROL_QUERY);
+	if (!put_str(buf, source) || !put_str(buf, filter)) {
+		fprintf(stderr, "names too long\n");
+		return false;
+	}
+	if (!transact(fd, buf))
+		return false;
+
+	running = get_uint(buf, 1) != 0;
+	at_end = get_uint(buf, 1) != 0;
+	progress = get_f32(buf);
+	if (truncated(buf))
+		return false;
+
+	printf("%s, %s, progress %.3f\n", running ? "running" : "idle",
+		at_end ? "at end" : "at start", progress);
+	return true;
+}
+
+static bool latency(int fd, struct buffer *buf)
+{
+	uint64_t count, min, mean, p99, max;
+
+	begin(buf, CONTROL_LATENCY);
+	if (!transact(fd, buf))
+		return false;
+
+	count = get_uint(buf, 8);
+	min = get_uint(buf, 8);
+	mean = get_uint(buf, 8);
+	p99 = get_uint(buf, 8);
+	max = get_uint(buf, 8);
+	if (truncated(buf))
+		return false;
+
+	printf("n=%llu min=%.3f mean=%.3f p99=%.3f max=%.3f (ms)\n",
+		(unsigned long long)count, min / 1000000.0, mean / 1000000.0,
+		p99 / 1000000.0, max / 1000000.0);
+	return true;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [--socket PATH] list\n"
+		"       %s [--socket PATH] trigger <source> <filter> "
+		"[--backward] [--offset S] [--repeat N]\n"
+		"       %s [--socket PATH] query <source> [<filter>]\n"
+		"       %s [--socket PATH] latency\n", name, name, name, name);
+}
+
+int main(int argc, char **argv)
+{
+	static struct buffer buf;
+	const char *path = getenv(CONTROL_ENV);
+	const char *args[3] = {NULL, NULL, NULL};
+	size_t num_args = 0, repeat = 1;
+	bool forward = true, ok;
+	float offset = 0.0f;
+	int fd;
+
+	for (int i = 1; i < argc; i++) {
+		const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+		bool valid = true;
+
+		if (strcmp(argv[i], "--socket") == 0) {
+			path = value;
+			valid = value != NULL;
+			i++;
+		} else if (strcmp(argv[i], "--backward") == 0) {
+			forward = false;
+		} else if (strcmp(argv[i], "--offset") == 0) {
+			offset = value ? (float)atof(value) : 0.0f;
+			valid = value != NULL;
+			i++;
+		} else if (strcmp(argv[i], "--repeat") == 0) {
+			repeat = value ? (size_t)atol(value) : 0;
+			valid = repeat > 0;
+			i++;
+		} else if (argv[i][0] != '-' && num_args < 3) {
+			args[num_args++] = argv[i];
+		} else {
+			valid = false;
+		}
+
+		if (!valid) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (!num_args || !path || !*path) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	fd = connect_socket(path);
+	if (fd < 0)
+		return 2;
+
+	if (strcmp(args[0], "list") == 0 && num_args == 1) {
+		ok = list(fd, &buf);
+	} else if (strcmp(args[0], "trigger") == 0 && num_args == 3) {
+		ok = trigger(fd, &buf, args[1], args[2], forward, offset,
+			repeat);
+	} else if (strcmp(args[0], "query") == 0 && num_args >= 2) {
+		ok = query(fd, &buf, args[1], num_args == 3 ? args[2] : "");
+	} else if (strcmp(args[0], "latency") == 0 && num_args == 1) {
+		ok = latency(fd, &buf);
+	} else {
+		usage(argv[0]);
+		close(fd);
+		return 1;
+	}
+
+	close(fd);
+	return ok ? 0 : 2;
+}
@@ -0,0 +1,864 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+/*
+ * Offline inspector for OBS scene collections. Loads a collection JSON
+ * (the files under basic/scenes/ in the OBS config directory) into the
+ * libobs stand-in and runs every motion filter and motion transition in
+ * it through the plugin's own code:
+ *
+ *   motion-inspect [--canvas WxH] [--fps N] [--source-size WxH]
+ *                  [--transforms] <scene collection .json>
+ *
+ * Filters are triggered once in each direction they support, loops and
+ * ping-pongs run for one period, and each transition runs between every
+ * pair of neighbouring scenes in the collection's scene order. The JSON
+ * report on stdout has per-frame costs, a per-frame CPU estimate for the
+ * whole collection and warnings; with --transforms it also lists the
+ * transforms of every simulated frame.
+ * Times are measured on the machine running the tool, without rendering.
+ *
+ * The canvas size and frame rate live in the profile, not the collection,
+ * and sizes of sources other than scenes and fixed-size sources are not
+ * stored at all, so those are taken from the options.
+ */
+
+#include "obs-standin.h"
+#include "../src/thread-pool.h"
+#include "../src/motion-transition/transition-plan.h"
+#include "../src/motion-filter/motion-filter.c"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEFAULT_CANVAS_WIDTH   1920
+#define DEFAULT_CANVAS_HEIGHT  1080
+#define DEFAULT_FPS            60
+#define DEFAULT_SOURCE_WIDTH   640
+#define DEFAULT_SOURCE_HEIGHT  360
+#define DEFAULT_TRANSITION_MS  300
+#define DEFAULT_SMALL_AREA     16384
+#define IDLE_TICKS             1000
+#define MAX_MOTION_FRAMES      100000
+#define IDLE_FILTER_WARN       100
+#define LARGE_SCENE_ITEMS      1000
+
+#define TRANSITION_RENDER_DIRECT 1
+
+struct inspect_source {
+	char                *name;
+	obs_source_t        *source;
+	obs_scene_t         *scene;
+	obs_data_t          *json;
+};
+
+struct frame_cost {
+	uint64_t            count;
+	uint64_t            sum;
+	uint64_t            max;
+};
+
+struct inspect {
+	struct inspect_source *sources;
+	size_t              num_sources;
+	struct dstr         warnings;
+	size_t              num_warnings;
+	size_t              estimated_sizes;
+	size_t              num_filters;
+	uint64_t            idle_ns;
+	uint64_t            worst_filter_ns;
+	uint64_t            worst_transition_ns;
+	uint64_t            worst_setup_ns;
+	uint32_t            canvas_width;
+	uint32_t            canvas_height;
+	uint32_t            fps;
+	uint32_t            source_width;
+	uint32_t            source_height;
+	bool                transforms;
+	bool                first_entry;
+};
+
+/* ------------------------------------------------------------------------- */
+/* output */
+
+static void print_string(const char *str)
+{
+	putchar('"');
+	for (; str && *str; str++) {
+		unsigned char c = (unsigned char)*str;
+		if (c == '"' || c == '\\')
+			printf("\\%c", c);
+		else if (c < 0x20)
+			printf("\\u%04x", c);
+		else
+			putchar(c);
+	}
+	putchar('"');
+}
+
+static void add_warning(struct inspect *ins, const char *format, ...)
+{
+	char msg[512];
+	va_list args;
+
+	va_start(args, format);
+	vsnprintf(msg, sizeof(msg), format, args);
+	va_end(args);
+
+	/* kept as one NUL-separated block, printed at the end */
+	dstr_ncat(&ins->warnings, msg, strlen(msg) + 1);
+	ins->num_warnings++;
+}
+
+static void begin_entry(struct inspect *ins, const char *type,
+	const char *name)
+{
+	printf("%s\n\t\t{\"type\": \"%s\", \"name\": ",
+		ins->first_entry ? "" : ",", type);
+	print_string(name);
+	ins->first_entry = false;
+}
+
+static void add_cost(struct frame_cost *cost, uint64_t ns)
+{
+	cost->count++;
+	cost->sum += ns;
+	if (ns > cost->max)
+		cost->max = ns;
+}
+
+static inline uint64_t mean_cost(const struct frame_cost *cost)
+{
+	return cost->count ? cost->sum / cost->count : 0;
+}
+
+static inline double frame_budget_ms(struct inspect *ins)
+{
+	return 1000.0 / ins->fps;
+}
+
+/* ------------------------------------------------------------------------- */
+/* loading */
+
+static struct inspect_source *find_source(struct inspect *ins,
+	const char *name)
+{
+	for (size_t i = 0; i < ins->num_sources; i++) {
+		if (strcmp(ins->sources[i].name, name) == 0)
+			return &ins->sources[i];
+	}
+
+	return NULL;
+}
+
+static inline bool is_scene_id(const char *id)
+{
+	return strcmp(id, "scene") == 0 || strcmp(id, "group") == 0;
+}
+
+static void add_scene_filters(obs_source_t *source, obs_data_t *json)
+{
+	obs_data_array_t *filters = obs_data_get_array(json, "filters");
+
+	for (size_t f = 0; f < obs_data_array_count(filters); f++) {
+		obs_data_t *filter = obs_data_array_item(filters, f);
+		const char *id = obs_data_get_string(filter, "id");
+
+		standin_source_add_filter(source, id, OBS_SOURCE_VIDEO);
+		obs_data_release(filter);
+	}
+
+	obs_data_array_release(filters);
+}
+
+static void add_source(struct inspect *ins, obs_data_t *json)
+{
+	struct inspect_source *src = &ins->sources[ins->num_sources++];
+	obs_data_t *settings = obs_data_get_obj(json, "settings");
+	const char *id = obs_data_get_string(json, "id");
+	uint32_t width = (uint32_t)obs_data_get_int(settings, "width");
+	uint32_t height = (uint32_t)obs_data_get_int(settings, "height");
+
+	src->name = bstrdup(obs_data_get_string(json, "name"));
+	src->json = json;
+	obs_data_addref(json);
+
+	if (strcmp(id, "group") == 0) {
+		/* groups store their bounding box as cx/cy */
+		src->scene = standin_group_create();
+		src->source = standin_scene_source(src->scene, src->name);
+		standin_source_set_size(src->source,
+			(uint32_t)obs_data_get_int(settings, "cx"),
+			(uint32_t)obs_data_get_int(settings, "cy"));
+	} else if (is_scene_id(id)) {
+		src->scene = standin_scene_create();
+		src->source = standin_scene_source(src->scene, src->name);
+		standin_source_set_size(src->source, ins->canvas_width,
+			ins->canvas_height);
+	} else {
+		/* color and browser sources store a size, most others don't */
+		if (!width || !height) {
+			width = ins->source_width;
+			height = ins->source_height;
+			ins->estimated_sizes++;
+		}
+		src->source = standin_source_create(src->name, width, height);
+		standin_source_set_id(src->source, id);
+	}
+
+	/* scenes have no audio, so all of their filters are video filters */
+	if (src->scene)
+		add_scene_filters(src->source, json);
+
+	obs_data_release(settings);
+}
+
+static void get_vec2(obs_data_t *data, const char *name, struct vec2 *vec)
+{
+	obs_data_t *obj = obs_data_get_obj(data, name);
+	vec->x = (float)obs_data_get_double(obj, "x");
+	vec->y = (float)obs_data_get_double(obj, "y");
+	obs_data_release(obj);
+}
+
+static void add_item(struct inspect *ins, struct inspect_source *scene,
+	obs_data_t *json)
+{
+	struct inspect_source *src = find_source(ins,
+		obs_data_get_string(json, "name"));
+	struct obs_transform_info info;
+	struct obs_sceneitem_crop crop;
+	obs_sceneitem_t *item;
+
+	if (!src)
+		return;
+
+	memset(&info, 0, sizeof(info));
+	get_vec2(json, "pos", &info.pos);
+	get_vec2(json, "scale", &info.scale);
+	get_vec2(json, "bounds", &info.bounds);
+	info.rot = (float)obs_data_get_double(json, "rot");
+	info.alignment = (uint32_t)obs_data_get_int(json, "align");
+	info.bounds_type = (enum obs_bounds_type)obs_data_get_int(json,
+		"bounds_type");
+	info.bounds_alignment = (uint32_t)obs_data_get_int(json,
+		"bounds_align");
+
+	item = standin_scene_add(scene->scene, src->source, &info);
+
+	crop.left = (int)obs_data_get_int(json, "crop_left");
+	crop.top = (int)obs_data_get_int(json, "crop_top");
+	crop.right = (int)obs_data_get_int(json, "crop_right");
+	crop.bottom = (int)obs_data_get_int(json, "crop_bottom");
+	obs_sceneitem_set_crop(item, &crop);
+	obs_sceneitem_set_scale_filter(item, (enum obs_scale_type)
+		obs_data_get_int(json, "scale_filter"));
+
+	if (obs_data_has_user_value(json, "visible"))
+		obs_sceneitem_set_visible(item,
+			obs_data_get_bool(json, "visible"));
+}
+
+static void add_items(struct inspect *ins, struct inspect_source *scene)
+{
+	obs_data_t *settings = obs_data_get_obj(scene->json, "settings");
+	obs_data_array_t *items = obs_data_get_array(settings, "items");
+	size_t count = obs_data_array_count(items);
+
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *item = obs_data_array_item(items, i);
+		add_item(ins, scene, item);
+		obs_data_release(item);
+	}
+
+	if (count > LARGE_SCENE_ITEMS)
+		add_warning(ins, "scene '%s' has %zu items; transitions into or "
+			"out of it need a long setup", scene->name, count);
+
+	obs_data_array_release(items);
+	obs_data_release(settings);
+}
+
+static bool load_collection(struct inspect *ins, obs_data_t *root)
+{
+	static const char *lists[] = {"sources", "groups"};
+	size_t total = 0;
+
+	for (size_t l = 0; l < 2; l++) {
+		obs_data_array_t *array = obs_data_get_array(root, lists[l]);
+		total += obs_data_array_count(array);
+		obs_data_array_release(array);
+	}
+
+	if (!total)
+		return false;
+
+	ins->sources = bzalloc(sizeof(struct inspect_source) * total);
+
+	for (size_t l = 0; l < 2; l++) {
+		obs_data_array_t *array = obs_data_get_array(root, lists[l]);
+
+		for (size_t i = 0; i < obs_data_array_count(array); i++) {
+			obs_data_t *json = obs_data_array_item(array, i);
+			add_source(ins, json);
+			obs_data_release(json);
+		}
+
+		obs_data_array_release(array);
+	}
+
+	for (size_t i = 0; i < ins->num_sources; i++) {
+		if (ins->sources[i].scene)
+			add_items(ins, &ins->sources[i]);
+	}
+
+	if (ins->estimated_sizes)
+		add_warning(ins, "%zu source sizes are not stored in the "
+			"collection and were taken as %ux%u (--source-size)",
+			ins->estimated_sizes, ins->source_width,
+			ins->source_height);
+	return true;
+}
+
+static void free_collection(struct inspect *ins)
+{
+	/* scenes first, their items point at the other sources */
+	for (size_t i = 0; i < ins->num_sources; i++) {
+		struct inspect_source *src = &ins->sources[i];
+		if (src->scene)
+			standin_scene_destroy(src->scene);
+	}
+
+	for (size_t i = 0; i < ins->num_sources; i++) {
+		struct inspect_source *src = &ins->sources[i];
+		if (!src->scene)
+			standin_source_destroy(src->source);
+		obs_data_release(src->json);
+		bfree(src->name);
+	}
+
+	bfree(ins->sources);
+}
+
+/* ------------------------------------------------------------------------- */
+/* motion filters */
+
+static void print_filter_transform(motion_filter_data_t *filter, bool first)
+{
+	struct obs_transform_info info;
+
+	obs_sceneitem_get_info(filter->item, &info);
+	printf("%s[%.3f, %.3f, %.5f, %.5f]", first ? "" : ", ",
+		info.pos.x, info.pos.y, info.scale.x, info.scale.y);
+}
+
+/*
+ * One trigger, ticked at the canvas frame rate until the motion ends.
+ * Returns false if the filter did not start.
+ */
+static bool run_motion(struct inspect *ins, motion_filter_data_t *filter,
+	bool forward, bool first)
+{
+	struct frame_cost cost = {0};
+	float seconds = 1.0f / ins->fps;
+	uint64_t max_frames = MAX_MOTION_FRAMES;
+
+	if (!motion_init(filter, forward))
+		return false;
+
+	/* a loop or ping-pong runs one period, then is stopped */
+	if (is_cyclic(filter))
+		max_frames = (uint64_t)ceil(cycle_period(filter) * ins->fps) + 1;
+
+	printf("%s{\"direction\": \"%s\"", first ? "" : ", ",
+		forward ? "forward" : "backward");
+	if (ins->transforms)
+		printf(", \"transforms\": [");
+
+	while (filter->motion_start && cost.count < max_frames) {
+		uint64_t start = os_gettime_ns();
+		motion_filter_tick(filter, seconds);
+		add_cost(&cost, os_gettime_ns() - start);
+
+		if (ins->transforms)
+			print_filter_transform(filter, cost.count == 1);
+	}
+
+	if (filter->motion_start)
+		motion_init(filter, false);
+
+	printf("%s\"frames\": %llu, \"frame_ns\": {\"mean\": %llu, "
+		"\"max\": %llu}}", ins->transforms ? "], " : ", ",
+		(unsigned long long)cost.count,
+		(unsigned long long)mean_cost(&cost),
+		(unsigned long long)cost.max);
+
+	if (mean_cost(&cost) > ins->worst_filter_ns)
+		ins->worst_filter_ns = mean_cost(&cost);
+	return true;
+}
+
+static void inspect_filter(struct inspect *ins, struct inspect_source *parent,
+	obs_data_t *json)
+{
+	obs_data_t *settings = obs_data_get_obj(json, "settings");
+	const char *name = obs_data_get_string(json, "name");
+	struct obs_transform_info saved;
+	struct obs_sceneitem_crop saved_crop;
+	motion_filter_data_t *filter;
+	obs_source_t *context;
+	obs_sceneitem_t *item;
+	uint64_t start;
+	bool forward;
+
+	if (!settings)
+		settings = obs_data_create();
+
+	motion_filter_defaults(settings);
+	context = standin_filter_create(parent->source, name, settings);
+	filter = motion_filter_create(settings, context);
+	if (standin_source_take_update(context))
+		motion_filter_update(filter, settings);
+
+	/* hotkeys and frontend callbacks have nothing to attach to here */
+	filter->initialize = true;
+
+	/* what every frame costs while the filter waits for a trigger */
+	start = os_gettime_ns();
+	for (size_t i = 0; i < IDLE_TICKS; i++)
+		motion_filter_tick(filter, 1.0f / ins->fps);
+	ins->idle_ns += (os_gettime_ns() - start) / IDLE_TICKS;
+	ins->num_filters++;
+
+	begin_entry(ins, "filter", name);
+	printf(", \"scene\": ");
+	print_string(parent->name);
+	printf(", \"source\": ");
+	print_string(filter->item_name);
+	printf(", \"behavior\": %d, \"path_type\": %d, \"duration\": %.3f, "
+		"\"runs\": [", filter->motion_behavior, filter->path_type,
+		filter->duration);
+
+	item = get_item(context, filter->item_name);
+	if (!item)
+		item = get_item_by_id(context, filter->item_id);
+	if (item) {
+		obs_sceneitem_get_info(item, &saved);
+		obs_sceneitem_get_crop(item, &saved_crop);
+	}
+
+	forward = !is_reverse(filter);
+	if (!item || !run_motion(ins, filter, forward, true)) {
+		add_warning(ins, "filter '%s' on '%s': source '%s' is not in "
+			"the scene", name, parent->name, filter->item_name);
+	} else if (!is_reverse(filter) != forward) {
+		run_motion(ins, filter, !forward, false);
+	}
+
+	printf("]}");
+
+	if (!filter->channels)
+		add_warning(ins, "filter '%s' on '%s' changes nothing on its "
+			"source", name, parent->name);
+	else if (filter->path_type != PATH_SPRING &&
+			filter->duration * ins->fps < 1.0f)
+		add_warning(ins, "filter '%s' on '%s': duration %.3f s is "
+			"shorter than a frame", name, parent->name,
+			filter->duration);
+
+	motion_filter_remove(filter, context);
+	motion_filter_destroy(filter);
+
+	/* leave the scene as loaded for the filters and transitions after */
+	if (item) {
+		obs_sceneitem_set_pos(item, &saved.pos);
+		obs_sceneitem_set_scale(item, &saved.scale);
+		obs_sceneitem_set_rot(item, saved.rot);
+		obs_sceneitem_set_bounds(item, &saved.bounds);
+		obs_sceneitem_set_crop(item, &saved_crop);
+	}
+
+	standin_source_destroy(context);
+	obs_data_release(settings);
+}
+
+static void inspect_filters(struct inspect *ins)
+{
+	for (size_t i = 0; i < ins->num_sources; i++) {
+		struct inspect_source *src = &ins->sources[i];
+		obs_data_array_t *filters = obs_data_get_array(src->json,
+			"filters");
+
+		for (size_t f = 0; f < obs_data_array_count(filters); f++) {
+			obs_data_t *json = obs_data_array_item(filters, f);
+			const char *id = obs_data_get_string(json, "id");
+
+			if (strcmp(id, "motion-filter") != 0) {
+				/* not ours */
+			} else if (!src->scene) {
+				add_warning(ins, "filter '%s' is on '%s', which "
+					"is not a scene; it never moves anything",
+					obs_data_get_string(json, "name"),
+					src->name);
+			} else {
+				inspect_filter(ins, src, json);
+			}
+
+			obs_data_release(json);
+		}
+
+		obs_data_array_release(filters);
+	}
+
+	if (ins->num_filters >= IDLE_FILTER_WARN)
+		add_warning(ins, "%zu motion filters tick every frame even when "
+			"idle (%.1f us per frame)", ins->num_filters,
+			ins->idle_ns / 1000.0);
+}
+
+/* ------------------------------------------------------------------------- */
+/* motion transitions */
+
+static void print_plan_frame(list_info_t *list, float t, bool first)
+{
+	printf("%s{\"t\": %.4f, \"items\": [", first ? "" : ", ", t);
+
+	for (size_t i = 0; i < list->num_items; i++) {
+		struct obs_transform_info *info = &list->states[i].info;
+
+		printf("%s[", i ? ", " : "");
+		print_string(obs_source_get_name(list->items[i].source));
+		printf(", %.3f, %.3f, %.5f, %.5f]", info->pos.x, info->pos.y,
+			info->scale.x, info->scale.y);
+	}
+
+	printf("]}");
+}
+
+/*
+ * One transition from scene a to scene b, laid out like
+ * motion_transition_video_render without the governor: the plan is built
+ * on the live scenes in direct mode if it can be, on duplicates otherwise,
+ * and every frame evaluates and commits the half it is in.
+ */
+static void run_transition(struct inspect *ins, const char *name,
+	transition_plan_t *plan, int render_mode, size_t frames,
+	struct inspect_source *a, struct inspect_source *b)
+{
+	struct frame_cost cost = {0};
+	obs_scene_t *dup_a = NULL, *dup_b = NULL;
+	uint64_t start = os_gettime_ns();
+	uint64_t dup_ns = 0, setup_ns;
+
+	if (render_mode == TRANSITION_RENDER_DIRECT) {
+		plan->out_list.scene = a->scene;
+		plan->in_list.scene = b->scene;
+		plan->direct_render = true;
+		snapshot_scenes(plan);
+		plan->direct_render = can_render_direct(plan);
+	}
+
+	if (!plan->direct_render) {
+		uint64_t dup_start = os_gettime_ns();
+		dup_a = standin_scene_duplicate(a->scene);
+		dup_b = standin_scene_duplicate(b->scene);
+		dup_ns = os_gettime_ns() - dup_start;
+		plan->out_list.scene = dup_a;
+		plan->in_list.scene = dup_b;
+		snapshot_scenes(plan);
+	}
+
+	create_item_list(plan);
+	setup_ns = os_gettime_ns() - start;
+
+	begin_entry(ins, "transition", name);
+	printf(", \"from\": ");
+	print_string(a->name);
+	printf(", \"to\": ");
+	print_string(b->name);
+	printf(", \"mode\": \"%s\", \"items\": {\"out\": %zu, \"in\": %zu}, "
+		"\"setup_ns\": %llu, \"duplicate_ns\": %llu",
+		plan->direct_render ? "direct" : "duplicate",
+		plan->out_list.num_items, plan->in_list.num_items,
+		(unsigned long long)setup_ns, (unsigned long long)dup_ns);
+
+	if (ins->transforms)
+		printf(", \"transforms\": [");
+
+	for (size_t f = 0; f < frames; f++) {
+		float t = (float)(f + 1) / (float)(frames + 1);
+		list_info_t *list = t <= 0.5f ? &plan->out_list :
+			&plan->in_list;
+		uint64_t touched = 0, setters = 0;
+		uint64_t frame_start = os_gettime_ns();
+
+		evaluate_items(plan, list, t, TIER_FULL, (uint32_t)f);
+		if (plan->direct_render)
+			render_items(plan, list, &touched);
+		else
+			commit_items(plan, list, TIER_FULL, &touched, &setters);
+		add_cost(&cost, os_gettime_ns() - frame_start);
+
+		if (ins->transforms)
+			print_plan_frame(list, t, f == 0);
+	}
+
+	printf("%s\"frames\": %zu, \"frame_ns\": {\"mean\": %llu, "
+		"\"max\": %llu}}", ins->transforms ? "], " : ", ", frames,
+		(unsigned long long)mean_cost(&cost),
+		(unsigned long long)cost.max);
+
+	release_plan(plan);
+	plan->direct_render = false;
+	standin_scene_destroy(dup_a);
+	standin_scene_destroy(dup_b);
+
+	if (setup_ns > ins->worst_setup_ns)
+		ins->worst_setup_ns = setup_ns;
+	if (mean_cost(&cost) > ins->worst_transition_ns)
+		ins->worst_transition_ns = mean_cost(&cost);
+
+	if (setup_ns / 1000000.0 > frame_budget_ms(ins))
+		add_warning(ins, "'%s' from '%s' to '%s': setup takes %.2f ms, "
+			"longer than a frame (%.2f ms), so the first frame "
+			"stalls", name, a->name,
+			b->name, setup_ns / 1000000.0, frame_budget_ms(ins));
+}
+
+/* the scenes in the order of the scene list, or as stored */
+static size_t get_scene_order(struct inspect *ins, obs_data_t *root,
+	struct inspect_source **order)
+{
+	obs_data_array_t *array = obs_data_get_array(root, "scene_order");
+	size_t count = 0;
+
+	for (size_t i = 0; i < obs_data_array_count(array); i++) {
+		obs_data_t *entry = obs_data_array_item(array, i);
+		struct inspect_source *src = find_source(ins,
+			obs_data_get_string(entry, "name"));
+		if (src && src->scene)
+			order[count++] = src;
+		obs_data_release(entry);
+	}
+
+	obs_data_array_release(array);
+
+	if (!count) {
+		for (size_t i = 0; i < ins->num_sources; i++) {
+			const char *id = obs_data_get_string(
+				ins->sources[i].json, "id");
+			if (strcmp(id, "scene") == 0)
+				order[count++] = &ins->sources[i];
+		}
+	}
+
+	return count;
+}
+
+static void inspect_transitions(struct inspect *ins, obs_data_t *root)
+{
+	obs_data_array_t *transitions = obs_data_get_array(root,
+		"transitions");
+	struct inspect_source **order = bzalloc(sizeof(*order) *
+		(ins->num_sources ? ins->num_sources : 1));
+	size_t num_scenes = get_scene_order(ins, root, order);
+	long long duration_ms = obs_data_has_user_value(root,
+		"transition_duration") ?
+		obs_data_get_int(root, "transition_duration") :
+		DEFAULT_TRANSITION_MS;
+	size_t frames = (size_t)(duration_ms * ins->fps / 1000);
+
+	for (size_t i = 0; i < obs_data_array_count(transitions); i++) {
+		obs_data_t *json = obs_data_array_item(transitions, i);
+		obs_data_t *settings = obs_data_get_obj(json, "settings");
+		transition_plan_t plan;
+		int render_mode;
+
+		if (strcmp(obs_data_get_string(json, "id"),
+				"motion-transition") != 0) {
+			obs_data_release(settings);
+			obs_data_release(json);
+			continue;
+		}
+
+		/* same mapping as motion_transition_update */
+		memset(&plan, 0, sizeof(plan));
+		plan.acc_x = -(float)obs_data_get_double(settings, "bezier_x") +
+			0.5f;
+		plan.acc_y = -(float)obs_data_get_double(settings, "bezier_y") +
+			0.5f;
+		plan.small_area = obs_data_has_user_value(settings,
+			"small_item_area") ? (float)obs_data_get_int(settings,
+			"small_item_area") : DEFAULT_SMALL_AREA;
+		plan.stagger = (enum stagger_mode)obs_data_get_int(settings,
+			"stagger");
+		plan.stagger_amount = obs_data_has_user_value(settings,
+			"stagger_amount") ? (float)obs_data_get_double(settings,
+			"stagger_amount") : 0.5f;
+		plan.stagger_reverse = obs_data_get_bool(settings,
+			"stagger_reverse");
+		plan.focal.x = obs_data_has_user_value(settings,
+			"stagger_focal_x") ? (float)obs_data_get_double(settings,
+			"stagger_focal_x") : 0.5f;
+		plan.focal.y = obs_data_has_user_value(settings,
+			"stagger_focal_y") ? (float)obs_data_get_double(settings,
+			"stagger_focal_y") : 0.5f;
+		render_mode = (int)obs_data_get_int(settings, "render_mode");
+
+		for (size_t s = 0; s + 1 < num_scenes; s++)
+			run_transition(ins, obs_data_get_string(json, "name"),
+				&plan, render_mode, frames, order[s],
+				order[s + 1]);
+
+		arena_free(&plan.arena);
+		obs_data_release(settings);
+		obs_data_release(json);
+	}
+
+	bfree(order);
+	obs_data_array_release(transitions);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void print_summary(struct inspect *ins)
+{
+	const char *msg = ins->warnings.array;
+
+	printf("\n\t],\n\t\"cpu_per_frame_ns\": {\"idle_filters\": %llu, "
+		"\"active_filter\": %llu, \"transition_frame\": %llu, "
+		"\"transition_setup\": %llu, \"budget\": %llu},\n"
+		"\t\"warnings\": [",
+		(unsigned long long)ins->idle_ns,
+		(unsigned long long)(ins->idle_ns + ins->worst_filter_ns),
+		(unsigned long long)(ins->idle_ns + ins->worst_transition_ns),
+		(unsigned long long)ins->worst_setup_ns,
+		(unsigned long long)(1000000000ULL / ins->fps));
+
+	for (size_t i = 0; i < ins->num_warnings; i++) {
+		printf("%s\n\t\t", i ? "," : "");
+		print_string(msg);
+		msg += strlen(msg) + 1;
+	}
+
+	printf("%s]\n}\n", ins->num_warnings ? "\n\t" : "");
+}
+
+static bool parse_size(const char *str, uint32_t *width, uint32_t *height)
+{
+	unsigned int w, h;
+
+	if (!str || sscanf(str, "%ux%u", &w, &h) != 2 || !w || !h)
+		return false;
+
+	*width = w;
+	*height = h;
+	return true;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [--canvas WxH] [--fps N] "
+		"[--source-size WxH] [--transforms] <collection.json>\n",
+		name);
+}
+
+int main(int argc, char **argv)
+{
+	struct inspect ins;
+	const char *path = NULL;
+	obs_data_t *root;
+
+	memset(&ins, 0, sizeof(ins));
+	ins.canvas_width = DEFAULT_CANVAS_WIDTH;
+	ins.canvas_height = DEFAULT_CANVAS_HEIGHT;
+	ins.fps = DEFAULT_FPS;
+	ins.source_width = DEFAULT_SOURCE_WIDTH;
+	ins.source_height = DEFAULT_SOURCE_HEIGHT;
+	ins.first_entry = true;
+
+	for (int i = 1; i < argc; i++) {
+		const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+		bool valid = true;
+
+		if (strcmp(argv[i], "--canvas") == 0) {
+			valid = parse_size(value, &ins.canvas_width,
+				&ins.canvas_height);
+			i++;
+		} else if (strcmp(argv[i], "--source-size") == 0) {
+			valid = parse_size(value, &ins.source_width,
+				&ins.source_height);
+			i++;
+		} else if (strcmp(argv[i], "--fps") == 0) {
+			ins.fps = value ? (uint32_t)atoi(value) : 0;
+			valid = ins.fps > 0;
+			i++;
+		} else if (strcmp(argv[i], "--transforms") == 0) {
+			ins.transforms = true;
+		} else if (argv[i][0] != '-' && !path) {
+			path = argv[i];
+		} else {
+			valid = false;
+		}
+
+		if (!valid) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (!path) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	root = obs_data_create_from_json_file(path);
+	if (!root) {
+		fprintf(stderr, "%s: cannot read scene collection\n", path);
+		return 2;
+	}
+
+	standin_video_set(ins.canvas_width, ins.canvas_height, ins.fps);
+	thread_pool_init();
+
+	if (!load_collection(&ins, root)) {
+		fprintf(stderr, "%s: no sources in scene collection\n", path);
+		obs_data_release(root);
+		thread_pool_free();
+		return 2;
+	}
+
+	printf("{\n\t\"collection\": ");
+	print_string(obs_data_get_string(root, "name"));
+	printf(",\n\t\"canvas\": [%u, %u],\n\t\"fps\": %u,\n"
+		"\t\"sources\": %zu,\n\t\"results\": [", ins.canvas_width,
+		ins.canvas_height, ins.fps, ins.num_sources);
+
+	inspect_filters(&ins);
+	inspect_transitions(&ins, root);
+	print_summary(&ins);
+
+	free_collection(&ins);
+	dstr_free(&ins.warnings);
+	obs_data_release(root);
+	thread_pool_free();
+	return 0;
+}
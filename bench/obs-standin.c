@@ -0,0 +1,1690 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+#include "obs-standin.h"
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/threading.h>
+#include <graphics/graphics.h>
+#include <graphics/matrix4.h>
+#include <obs-frontend-api.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MEM_HEADER        32
+#define MATRIX_STACK_SIZE 32
+
+struct obs_source {
+	char                *name;
+	char                *id;
+	uint32_t            width;
+	uint32_t            height;
+	volatile long       refs;
+	struct obs_source   *parent;
+	struct obs_scene    *scene;
+	struct obs_data     *settings;
+	bool                update_pending;
+	uint32_t            output_flags;
+	struct obs_source   *filters;
+	struct obs_source   *next_filter;
+};
+
+struct standin_value {
+	struct standin_value  *next;
+	char                  *name;
+	enum obs_data_number_type number;
+	long long             int_val;
+	double                double_val;
+	bool                  bool_val;
+	char                  *string_val;
+	struct obs_data       *obj_val;
+	struct obs_data_array *array_val;
+	bool                  has_value;
+	long long             default_int;
+	double                default_double;
+	bool                  default_bool;
+	char                  *default_string;
+	enum obs_data_number_type default_number;
+	bool                  has_default;
+};
+
+struct obs_data {
+	volatile long         refs;
+	struct standin_value  *first;
+};
+
+struct obs_data_array {
+	volatile long         refs;
+	struct obs_data       **items;
+	size_t                count;
+	size_t                capacity;
+};
+
+struct json_reader {
+	const char            *pos;
+	const char            *end;
+	bool                  error;
+};
+
+struct obs_scene_item {
+	struct obs_scene_item     *next;
+	struct obs_source         *source;
+	struct obs_transform_info info;
+	struct obs_sceneitem_crop crop;
+	enum obs_scale_type       scale_filter;
+	bool                      visible;
+	bool                      owns_group;
+	int64_t                   id;
+};
+
+struct obs_scene {
+	struct obs_source     *source;
+	struct obs_scene_item *first_item;
+	struct obs_scene_item *last_item;
+	int64_t               last_id;
+	bool                  group;
+};
+
+struct os_sem_data {
+	pthread_mutex_t     mutex;
+	pthread_cond_t      cond;
+	int                 count;
+};
+
+struct os_event_data {
+	pthread_mutex_t     mutex;
+	pthread_cond_t      cond;
+	volatile bool       signalled;
+	bool                manual;
+};
+
+static pthread_mutex_t mem_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct standin_mem mem;
+
+static volatile long setter_calls;
+static volatile long draw_calls;
+
+static uint32_t video_width = 1920;
+static uint32_t video_height = 1080;
+static uint32_t video_fps = 60;
+
+static struct matrix4 matrix_stack[MATRIX_STACK_SIZE];
+static size_t matrix_top;
+
+/* ------------------------------------------------------------------------- */
+/* memory and logging */
+
+void *bmalloc(size_t size)
+{
+	uint8_t *ptr = malloc(MEM_HEADER + (size ? size : 1));
+
+	if (!ptr) {
+		fprintf(stderr, "out of memory allocating %zu bytes\n", size);
+		abort();
+	}
+
+	*(size_t*)ptr = size;
+
+	pthread_mutex_lock(&mem_mutex);
+	mem.current += size;
+	if (mem.current > mem.peak)
+		mem.peak = mem.current;
+	mem.allocs++;
+	pthread_mutex_unlock(&mem_mutex);
+
+	return ptr + MEM_HEADER;
+}
+
+void bfree(void *ptr)
+{
+	uint8_t *block;
+
+	if (!ptr)
+		return;
+
+	block = (uint8_t*)ptr - MEM_HEADER;
+
+	pthread_mutex_lock(&mem_mutex);
+	mem.current -= *(size_t*)block;
+	pthread_mutex_unlock(&mem_mutex);
+
+	free(block);
+}
+
+void *brealloc(void *ptr, size_t size)
+{
+	void *new_ptr = bmalloc(size);
+
+	if (ptr) {
+		size_t old_size = *(size_t*)((uint8_t*)ptr - MEM_HEADER);
+		memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+		bfree(ptr);
+	}
+
+	return new_ptr;
+}
+
+void standin_mem_get(struct standin_mem *out)
+{
+	pthread_mutex_lock(&mem_mutex);
+	*out = mem;
+	pthread_mutex_unlock(&mem_mutex);
+}
+
+void standin_mem_reset_peak(void)
+{
+	pthread_mutex_lock(&mem_mutex);
+	mem.peak = mem.current;
+	pthread_mutex_unlock(&mem_mutex);
+}
+
+void blog(int log_level, const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	fprintf(stderr, "[%d] ", log_level);
+	vfprintf(stderr, format, args);
+	fprintf(stderr, "\n");
+	va_end(args);
+}
+
+/* ------------------------------------------------------------------------- */
+/* platform and threading */
+
+uint64_t os_gettime_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int os_get_logical_cores(void)
+{
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	return cores > 0 ? (int)cores : 1;
+}
+
+void os_set_thread_name(const char *name)
+{
+	UNUSED_PARAMETER(name);
+}
+
+int os_sem_init(os_sem_t **sem, int value)
+{
+	struct os_sem_data *data = bzalloc(sizeof(*data));
+
+	pthread_mutex_init(&data->mutex, NULL);
+	pthread_cond_init(&data->cond, NULL);
+	data->count = value;
+	*sem = data;
+	return 0;
+}
+
+void os_sem_destroy(os_sem_t *sem)
+{
+	if (!sem)
+		return;
+
+	pthread_cond_destroy(&sem->cond);
+	pthread_mutex_destroy(&sem->mutex);
+	bfree(sem);
+}
+
+int os_sem_post(os_sem_t *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	sem->count++;
+	pthread_cond_signal(&sem->cond);
+	pthread_mutex_unlock(&sem->mutex);
+	return 0;
+}
+
+int os_sem_wait(os_sem_t *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	while (sem->count <= 0)
+		pthread_cond_wait(&sem->cond, &sem->mutex);
+	sem->count--;
+	pthread_mutex_unlock(&sem->mutex);
+	return 0;
+}
+
+int os_event_init(os_event_t **event, enum os_event_type type)
+{
+	struct os_event_data *data = bzalloc(sizeof(*data));
+
+	pthread_mutex_init(&data->mutex, NULL);
+	pthread_cond_init(&data->cond, NULL);
+	data->manual = type == OS_EVENT_TYPE_MANUAL;
+	*event = data;
+	return 0;
+}
+
+void os_event_destroy(os_event_t *event)
+{
+	if (!event)
+		return;
+
+	pthread_cond_destroy(&event->cond);
+	pthread_mutex_destroy(&event->mutex);
+	bfree(event);
+}
+
+int os_event_wait(os_event_t *event)
+{
+	pthread_mutex_lock(&event->mutex);
+	while (!event->signalled)
+		pthread_cond_wait(&event->cond, &event->mutex);
+	if (!event->manual)
+		event->signalled = false;
+	pthread_mutex_unlock(&event->mutex);
+	return 0;
+}
+
+int os_event_signal(os_event_t *event)
+{
+	pthread_mutex_lock(&event->mutex);
+	event->signalled = true;
+	pthread_cond_signal(&event->cond);
+	pthread_mutex_unlock(&event->mutex);
+	return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+/* graphics: matrix math and the matrix stack, no actual drawing */
+
+void matrix4_mul(struct matrix4 *dst, const struct matrix4 *m1,
+	const struct matrix4 *m2)
+{
+	const struct vec4 *r1 = &m1->x;
+	const struct vec4 *r2 = &m2->x;
+	struct matrix4 out;
+	struct vec4 *o = &out.x;
+
+	for (size_t i = 0; i < 4; i++) {
+		o[i].x = r1[i].x * r2[0].x + r1[i].y * r2[1].x +
+			r1[i].z * r2[2].x + r1[i].w * r2[3].x;
+		o[i].y = r1[i].x * r2[0].y + r1[i].y * r2[1].y +
+			r1[i].z * r2[2].y + r1[i].w * r2[3].y;
+		o[i].z = r1[i].x * r2[0].z + r1[i].y * r2[1].z +
+			r1[i].z * r2[2].z + r1[i].w * r2[3].z;
+		o[i].w = r1[i].x * r2[0].w + r1[i].y * r2[1].w +
+			r1[i].z * r2[2].w + r1[i].w * r2[3].w;
+	}
+
+	*dst = out;
+}
+
+void matrix4_translate3v(struct matrix4 *dst, const struct matrix4 *m,
+	const struct vec3 *v)
+{
+	struct matrix4 temp;
+
+	matrix4_identity(&temp);
+	temp.t.x = v->x;
+	temp.t.y = v->y;
+	temp.t.z = v->z;
+	matrix4_mul(dst, m, &temp);
+}
+
+void matrix4_scale(struct matrix4 *dst, const struct matrix4 *m,
+	const struct vec3 *v)
+{
+	struct matrix4 temp;
+
+	matrix4_identity(&temp);
+	temp.x.x = v->x;
+	temp.y.y = v->y;
+	temp.z.z = v->z;
+	matrix4_mul(dst, m, &temp);
+}
+
+/* row-vector convention, same as libobs */
+void matrix4_rotate_aa(struct matrix4 *dst, const struct matrix4 *m,
+	const struct axisang *aa)
+{
+	struct matrix4 temp;
+	float c = cosf(aa->w);
+	float s = sinf(aa->w);
+	float t = 1.0f - c;
+	float x = aa->x, y = aa->y, z = aa->z;
+
+	matrix4_identity(&temp);
+	temp.x.x = t * x * x + c;
+	temp.x.y = t * x * y + s * z;
+	temp.x.z = t * x * z - s * y;
+	temp.y.x = t * x * y - s * z;
+	temp.y.y = t * y * y + c;
+	temp.y.z = t * y * z + s * x;
+	temp.z.x = t * x * z + s * y;
+	temp.z.y = t * y * z - s * x;
+	temp.z.z = t * z * z + c;
+	matrix4_mul(dst, m, &temp);
+}
+
+void gs_matrix_push(void)
+{
+	if (matrix_top + 1 < MATRIX_STACK_SIZE) {
+		matrix_stack[matrix_top + 1] = matrix_stack[matrix_top];
+		matrix_top++;
+	}
+}
+
+void gs_matrix_pop(void)
+{
+	if (matrix_top)
+		matrix_top--;
+}
+
+void gs_matrix_mul(const struct matrix4 *matrix)
+{
+	matrix4_mul(&matrix_stack[matrix_top], matrix,
+		&matrix_stack[matrix_top]);
+}
+
+/* ------------------------------------------------------------------------- */
+/* video */
+
+bool obs_get_video_info(struct obs_video_info *ovi)
+{
+	memset(ovi, 0, sizeof(*ovi));
+	ovi->base_width = ovi->output_width = video_width;
+	ovi->base_height = ovi->output_height = video_height;
+	ovi->fps_num = video_fps;
+	ovi->fps_den = 1;
+	return true;
+}
+
+void standin_video_set(uint32_t width, uint32_t height, uint32_t fps)
+{
+	video_width = width;
+	video_height = height;
+	video_fps = fps;
+}
+
+/* ------------------------------------------------------------------------- */
+/* sources */
+
+obs_source_t *standin_source_create(const char *name, uint32_t width,
+	uint32_t height)
+{
+	struct obs_source *source = bzalloc(sizeof(*source));
+	size_t len = strlen(name);
+
+	source->name = bmalloc(len + 1);
+	memcpy(source->name, name, len + 1);
+	source->width = width;
+	source->height = height;
+	source->refs = 1;
+	return source;
+}
+
+void standin_source_set_id(obs_source_t *source, const char *id)
+{
+	bfree(source->id);
+	source->id = bstrdup(id);
+}
+
+void standin_source_set_size(obs_source_t *source, uint32_t width,
+	uint32_t height)
+{
+	source->width = width;
+	source->height = height;
+}
+
+obs_source_t *standin_filter_create(obs_source_t *parent, const char *name,
+	obs_data_t *settings)
+{
+	obs_source_t *source = standin_source_create(name, 0, 0);
+
+	source->parent = parent;
+	source->settings = settings;
+	obs_data_addref(settings);
+	return source;
+}
+
+obs_source_t *standin_source_add_filter(obs_source_t *source,
+	const char *id, uint32_t output_flags)
+{
+	obs_source_t *filter = standin_source_create(id, 0, 0);
+
+	standin_source_set_id(filter, id);
+	filter->parent = source;
+	filter->output_flags = output_flags;
+	filter->next_filter = source->filters;
+	source->filters = filter;
+	return filter;
+}
+
+bool standin_source_take_update(obs_source_t *source)
+{
+	bool pending = source->update_pending;
+	source->update_pending = false;
+	return pending;
+}
+
+void standin_source_destroy(obs_source_t *source)
+{
+	if (source) {
+		while (source->filters) {
+			obs_source_t *next = source->filters->next_filter;
+			standin_source_destroy(source->filters);
+			source->filters = next;
+		}
+		obs_data_release(source->settings);
+		bfree(source->id);
+		bfree(source->name);
+		bfree(source);
+	}
+}
+
+obs_data_t *obs_source_get_settings(const obs_source_t *source)
+{
+	if (!source || !source->settings)
+		return NULL;
+
+	obs_data_addref(source->settings);
+	return source->settings;
+}
+
+/* settings objects other than the source's own are not merged */
+void obs_source_update(obs_source_t *source, obs_data_t *settings)
+{
+	UNUSED_PARAMETER(settings);
+	if (source)
+		source->update_pending = true;
+}
+
+void obs_source_enum_filters(obs_source_t *source,
+	void (*callback)(obs_source_t *, obs_source_t *, void *), void *param)
+{
+	for (obs_source_t *filter = source ? source->filters : NULL; filter;
+			filter = filter->next_filter)
+		callback(source, filter, param);
+}
+
+bool obs_source_enabled(const obs_source_t *source)
+{
+	return source != NULL;
+}
+
+uint32_t obs_source_get_output_flags(const obs_source_t *source)
+{
+	return source ? source->output_flags : 0;
+}
+
+obs_source_t *obs_filter_get_parent(const obs_source_t *filter)
+{
+	return filter ? filter->parent : NULL;
+}
+
+void obs_source_addref(obs_source_t *source)
+{
+	if (source)
+		os_atomic_inc_long(&source->refs);
+}
+
+void obs_source_release(obs_source_t *source)
+{
+	if (source)
+		os_atomic_dec_long(&source->refs);
+}
+
+const char *obs_source_get_name(const obs_source_t *source)
+{
+	return source ? source->name : NULL;
+}
+
+const char *obs_source_get_id(const obs_source_t *source)
+{
+	if (!source)
+		return NULL;
+	if (source->scene)
+		return source->scene->group ? "group" : "scene";
+	return source->id ? source->id : "";
+}
+
+uint32_t obs_source_get_width(obs_source_t *source)
+{
+	return source ? source->width : 0;
+}
+
+uint32_t obs_source_get_height(obs_source_t *source)
+{
+	return source ? source->height : 0;
+}
+
+uint32_t obs_source_get_base_width(obs_source_t *source)
+{
+	return obs_source_get_width(source);
+}
+
+uint32_t obs_source_get_base_height(obs_source_t *source)
+{
+	return obs_source_get_height(source);
+}
+
+void obs_source_video_render(obs_source_t *source)
+{
+	UNUSED_PARAMETER(source);
+	os_atomic_inc_long(&draw_calls);
+}
+
+/* ------------------------------------------------------------------------- */
+/* scenes and scene items */
+
+obs_scene_t *standin_scene_create(void)
+{
+	return bzalloc(sizeof(struct obs_scene));
+}
+
+obs_source_t *standin_scene_source(obs_scene_t *scene, const char *name)
+{
+	if (!scene->source) {
+		scene->source = standin_source_create(name, 0, 0);
+		scene->source->scene = scene;
+	}
+
+	return scene->source;
+}
+
+obs_scene_t *standin_group_create(void)
+{
+	obs_scene_t *group = standin_scene_create();
+	group->group = true;
+	return group;
+}
+
+obs_scene_t *obs_scene_from_source(const obs_source_t *source)
+{
+	return source && source->scene && !source->scene->group ?
+		source->scene : NULL;
+}
+
+obs_source_t *obs_scene_get_source(const obs_scene_t *scene)
+{
+	return scene ? scene->source : NULL;
+}
+
+obs_scene_t *obs_group_from_source(const obs_source_t *source)
+{
+	return source && source->scene && source->scene->group ?
+		source->scene : NULL;
+}
+
+bool obs_sceneitem_is_group(obs_sceneitem_t *item)
+{
+	return item && obs_group_from_source(item->source) != NULL;
+}
+
+obs_scene_t *obs_sceneitem_group_get_scene(const obs_sceneitem_t *item)
+{
+	return item ? obs_group_from_source(item->source) : NULL;
+}
+
+/* groups are never refit to their items here, so there is nothing to defer */
+void obs_sceneitem_defer_group_resize_begin(obs_sceneitem_t *item)
+{
+	UNUSED_PARAMETER(item);
+}
+
+void obs_sceneitem_defer_group_resize_end(obs_sceneitem_t *item)
+{
+	UNUSED_PARAMETER(item);
+}
+
+obs_sceneitem_t *standin_scene_add(obs_scene_t *scene, obs_source_t *source,
+	const struct obs_transform_info *info)
+{
+	struct obs_scene_item *item = bzalloc(sizeof(*item));
+
+	item->source = source;
+	item->info = *info;
+	item->visible = true;
+	item->id = ++scene->last_id;
+
+	if (scene->last_item)
+		scene->last_item->next = item;
+	else
+		scene->first_item = item;
+	scene->last_item = item;
+	return item;
+}
+
+/*
+ * Copies every item, sharing the sources, like a private-refs duplicate.
+ * Groups belong to their scene, so as in libobs they are copied as well.
+ */
+obs_scene_t *standin_scene_duplicate(obs_scene_t *scene)
+{
+	obs_scene_t *copy = standin_scene_create();
+	struct obs_scene_item *item;
+
+	copy->group = scene->group;
+
+	for (item = scene->first_item; item; item = item->next) {
+		obs_source_t *source = item->source;
+		struct obs_scene_item *new_item;
+		bool group = obs_sceneitem_is_group(item);
+
+		if (group) {
+			obs_scene_t *group_copy = standin_scene_duplicate(
+				source->scene);
+			obs_source_t *group_source = standin_scene_source(
+				group_copy, source->name);
+			standin_source_set_size(group_source, source->width,
+				source->height);
+			source = group_source;
+		}
+
+		new_item = standin_scene_add(copy, source, &item->info);
+		new_item->crop = item->crop;
+		new_item->scale_filter = item->scale_filter;
+		new_item->visible = item->visible;
+		new_item->owns_group = group;
+	}
+
+	return copy;
+}
+
+void standin_scene_destroy(obs_scene_t *scene)
+{
+	struct obs_scene_item *item;
+
+	if (!scene)
+		return;
+
+	item = scene->first_item;
+	while (item) {
+		struct obs_scene_item *next = item->next;
+		if (item->owns_group)
+			standin_scene_destroy(item->source->scene);
+		bfree(item);
+		item = next;
+	}
+
+	standin_source_destroy(scene->source);
+	bfree(scene);
+}
+
+void obs_scene_enum_items(obs_scene_t *scene,
+	bool (*callback)(obs_scene_t*, obs_sceneitem_t*, void*), void *param)
+{
+	struct obs_scene_item *item;
+
+	if (!scene)
+		return;
+
+	for (item = scene->first_item; item; item = item->next) {
+		if (!callback(scene, item, param))
+			break;
+	}
+}
+
+void obs_sceneitem_addref(obs_sceneitem_t *item)
+{
+	UNUSED_PARAMETER(item);
+}
+
+void obs_sceneitem_release(obs_sceneitem_t *item)
+{
+	UNUSED_PARAMETER(item);
+}
+
+obs_source_t *obs_sceneitem_get_source(const obs_sceneitem_t *item)
+{
+	return item ? item->source : NULL;
+}
+
+int64_t obs_sceneitem_get_id(const obs_sceneitem_t *item)
+{
+	return item ? item->id : 0;
+}
+
+void obs_sceneitem_get_info(const obs_sceneitem_t *item,
+	struct obs_transform_info *info)
+{
+	*info = item->info;
+}
+
+void obs_sceneitem_get_crop(const obs_sceneitem_t *item,
+	struct obs_sceneitem_crop *crop)
+{
+	*crop = item->crop;
+}
+
+enum obs_scale_type obs_sceneitem_get_scale_filter(obs_sceneitem_t *item)
+{
+	return item->scale_filter;
+}
+
+void obs_sceneitem_set_scale_filter(obs_sceneitem_t *item,
+	enum obs_scale_type filter)
+{
+	item->scale_filter = filter;
+}
+
+bool obs_sceneitem_visible(const obs_sceneitem_t *item)
+{
+	return item ? item->visible : false;
+}
+
+bool obs_sceneitem_set_visible(obs_sceneitem_t *item, bool visible)
+{
+	item->visible = visible;
+	os_atomic_inc_long(&setter_calls);
+	return true;
+}
+
+void obs_sceneitem_set_pos(obs_sceneitem_t *item, const struct vec2 *pos)
+{
+	item->info.pos = *pos;
+	os_atomic_inc_long(&setter_calls);
+}
+
+void obs_sceneitem_set_scale(obs_sceneitem_t *item, const struct vec2 *scale)
+{
+	item->info.scale = *scale;
+	os_atomic_inc_long(&setter_calls);
+}
+
+void obs_sceneitem_set_rot(obs_sceneitem_t *item, float rot_deg)
+{
+	item->info.rot = rot_deg;
+	os_atomic_inc_long(&setter_calls);
+}
+
+void obs_sceneitem_set_bounds(obs_sceneitem_t *item,
+	const struct vec2 *bounds)
+{
+	item->info.bounds = *bounds;
+	os_atomic_inc_long(&setter_calls);
+}
+
+void obs_sceneitem_set_crop(obs_sceneitem_t *item,
+	const struct obs_sceneitem_crop *crop)
+{
+	item->crop = *crop;
+	os_atomic_inc_long(&setter_calls);
+}
+
+obs_sceneitem_t *obs_scene_find_source(obs_scene_t *scene, const char *name)
+{
+	struct obs_scene_item *item;
+
+	for (item = scene ? scene->first_item : NULL; item; item = item->next) {
+		if (strcmp(item->source->name, name) == 0)
+			return item;
+	}
+
+	return NULL;
+}
+
+obs_sceneitem_t *obs_scene_find_sceneitem_by_id(obs_scene_t *scene,
+	int64_t id)
+{
+	struct obs_scene_item *item;
+
+	for (item = scene ? scene->first_item : NULL; item; item = item->next) {
+		if (item->id == id)
+			return item;
+	}
+
+	return NULL;
+}
+
+uint64_t standin_setter_calls(void)
+{
+	return (uint64_t)os_atomic_load_long(&setter_calls);
+}
+
+uint64_t standin_draw_calls(void)
+{
+	return (uint64_t)os_atomic_load_long(&draw_calls);
+}
+
+/* ------------------------------------------------------------------------- */
+/* settings */
+
+static struct standin_value *find_value(obs_data_t *data, const char *name,
+	bool create)
+{
+	struct standin_value *value;
+	size_t len;
+
+	if (!data || !name)
+		return NULL;
+
+	for (value = data->first; value; value = value->next) {
+		if (strcmp(value->name, name) == 0)
+			return value;
+	}
+
+	if (!create)
+		return NULL;
+
+	len = strlen(name);
+	value = bzalloc(sizeof(*value));
+	value->name = bmalloc(len + 1);
+	memcpy(value->name, name, len + 1);
+	value->next = data->first;
+	data->first = value;
+	return value;
+}
+
+static char *copy_string(char *old, const char *str)
+{
+	size_t len = str ? strlen(str) : 0;
+	char *copy = bmalloc(len + 1);
+
+	memcpy(copy, str ? str : "", len + 1);
+	bfree(old);
+	return copy;
+}
+
+obs_data_t *obs_data_create(void)
+{
+	obs_data_t *data = bzalloc(sizeof(*data));
+	data->refs = 1;
+	return data;
+}
+
+void obs_data_addref(obs_data_t *data)
+{
+	if (data)
+		os_atomic_inc_long(&data->refs);
+}
+
+void obs_data_release(obs_data_t *data)
+{
+	struct standin_value *value;
+
+	if (!data || os_atomic_dec_long(&data->refs) > 0)
+		return;
+
+	value = data->first;
+	while (value) {
+		struct standin_value *next = value->next;
+		obs_data_release(value->obj_val);
+		obs_data_array_release(value->array_val);
+		bfree(value->name);
+		bfree(value->string_val);
+		bfree(value->default_string);
+		bfree(value);
+		value = next;
+	}
+
+	bfree(data);
+}
+
+void obs_data_set_int(obs_data_t *data, const char *name, long long val)
+{
+	struct standin_value *value = find_value(data, name, true);
+	value->number = OBS_DATA_NUM_INT;
+	value->int_val = val;
+	value->has_value = true;
+}
+
+void obs_data_set_double(obs_data_t *data, const char *name, double val)
+{
+	struct standin_value *value = find_value(data, name, true);
+	value->number = OBS_DATA_NUM_DOUBLE;
+	value->double_val = val;
+	value->has_value = true;
+}
+
+void obs_data_set_bool(obs_data_t *data, const char *name, bool val)
+{
+	struct standin_value *value = find_value(data, name, true);
+	value->bool_val = val;
+	value->has_value = true;
+}
+
+void obs_data_set_string(obs_data_t *data, const char *name, const char *val)
+{
+	struct standin_value *value = find_value(data, name, true);
+	value->string_val = copy_string(value->string_val, val);
+	value->has_value = true;
+}
+
+void obs_data_set_default_int(obs_data_t *data, const char *name,
+	long long val)
+{
+	struct standin_value *value = find_value(data, name, true);
+	value->default_number = OBS_DATA_NUM_INT;
+	value->default_int = val;
+	value->has_default = true;
+}
+
+void obs_data_set_default_double(obs_data_t *data, const char *name,
+	double val)
+{
+	struct standin_value *value = find_value(data, name, true);
+	value->default_number = OBS_DATA_NUM_DOUBLE;
+	value->default_double = val;
+	value->has_default = true;
+}
+
+void obs_data_set_default_bool(obs_data_t *data, const char *name, bool val)
+{
+	struct standin_value *value = find_value(data, name, true);
+	value->default_bool = val;
+	value->has_default = true;
+}
+
+void obs_data_set_default_string(obs_data_t *data, const char *name,
+	const char *val)
+{
+	struct standin_value *value = find_value(data, name, true);
+	value->default_string = copy_string(value->default_string, val);
+	value->has_default = true;
+}
+
+/* numbers convert between int and double like obs_data does */
+long long obs_data_get_int(obs_data_t *data, const char *name)
+{
+	struct standin_value *value = find_value(data, name, false);
+
+	if (value && value->has_value)
+		return value->number == OBS_DATA_NUM_DOUBLE ?
+			(long long)value->double_val : value->int_val;
+	if (value && value->has_default)
+		return value->default_number == OBS_DATA_NUM_DOUBLE ?
+			(long long)value->default_double : value->default_int;
+	return 0;
+}
+
+double obs_data_get_double(obs_data_t *data, const char *name)
+{
+	struct standin_value *value = find_value(data, name, false);
+
+	if (value && value->has_value)
+		return value->number == OBS_DATA_NUM_INT ?
+			(double)value->int_val : value->double_val;
+	if (value && value->has_default)
+		return value->default_number == OBS_DATA_NUM_INT ?
+			(double)value->default_int : value->default_double;
+	return 0.0;
+}
+
+bool obs_data_get_bool(obs_data_t *data, const char *name)
+{
+	struct standin_value *value = find_value(data, name, false);
+
+	if (value && value->has_value)
+		return value->bool_val;
+	return value && value->has_default ? value->default_bool : false;
+}
+
+const char *obs_data_get_string(obs_data_t *data, const char *name)
+{
+	struct standin_value *value = find_value(data, name, false);
+
+	if (value && value->has_value && value->string_val)
+		return value->string_val;
+	if (value && value->has_default && value->default_string)
+		return value->default_string;
+	return "";
+}
+
+/* objects and arrays are shared by reference, like obs_data does */
+void obs_data_set_obj(obs_data_t *data, const char *name, obs_data_t *obj)
+{
+	struct standin_value *value = find_value(data, name, true);
+	obs_data_addref(obj);
+	obs_data_release(value->obj_val);
+	value->obj_val = obj;
+	value->has_value = true;
+}
+
+obs_data_t *obs_data_get_obj(obs_data_t *data, const char *name)
+{
+	struct standin_value *value = find_value(data, name, false);
+
+	if (!value || !value->obj_val)
+		return NULL;
+
+	obs_data_addref(value->obj_val);
+	return value->obj_val;
+}
+
+void obs_data_set_array(obs_data_t *data, const char *name,
+	obs_data_array_t *array)
+{
+	struct standin_value *value = find_value(data, name, true);
+	if (array)
+		os_atomic_inc_long(&array->refs);
+	obs_data_array_release(value->array_val);
+	value->array_val = array;
+	value->has_value = true;
+}
+
+obs_data_array_t *obs_data_get_array(obs_data_t *data, const char *name)
+{
+	struct standin_value *value = find_value(data, name, false);
+
+	if (!value || !value->array_val)
+		return NULL;
+
+	os_atomic_inc_long(&value->array_val->refs);
+	return value->array_val;
+}
+
+bool obs_data_has_user_value(obs_data_t *data, const char *name)
+{
+	struct standin_value *value = find_value(data, name, false);
+	return value && value->has_value;
+}
+
+obs_data_array_t *obs_data_array_create(void)
+{
+	obs_data_array_t *array = bzalloc(sizeof(*array));
+	array->refs = 1;
+	return array;
+}
+
+void obs_data_array_release(obs_data_array_t *array)
+{
+	if (!array || os_atomic_dec_long(&array->refs) > 0)
+		return;
+
+	for (size_t i = 0; i < array->count; i++)
+		obs_data_release(array->items[i]);
+	bfree(array->items);
+	bfree(array);
+}
+
+size_t obs_data_array_count(obs_data_array_t *array)
+{
+	return array ? array->count : 0;
+}
+
+obs_data_t *obs_data_array_item(obs_data_array_t *array, size_t idx)
+{
+	if (!array || idx >= array->count)
+		return NULL;
+
+	obs_data_addref(array->items[idx]);
+	return array->items[idx];
+}
+
+size_t obs_data_array_push_back(obs_data_array_t *array, obs_data_t *obj)
+{
+	if (array->count == array->capacity) {
+		array->capacity = array->capacity ? array->capacity * 2 : 8;
+		array->items = brealloc(array->items,
+			sizeof(obs_data_t*) * array->capacity);
+	}
+
+	obs_data_addref(obj);
+	array->items[array->count] = obj;
+	return array->count++;
+}
+
+/* ------------------------------------------------------------------------- */
+/* strings */
+
+void dstr_ncat(struct dstr *dst, const char *array, const size_t len)
+{
+	if (dst->len + len + 1 > dst->capacity) {
+		size_t capacity = dst->capacity ? dst->capacity * 2 : 32;
+		while (capacity < dst->len + len + 1)
+			capacity *= 2;
+		dst->array = brealloc(dst->array, capacity);
+		dst->capacity = capacity;
+	}
+
+	memcpy(dst->array + dst->len, array, len);
+	dst->len += len;
+	dst->array[dst->len] = 0;
+}
+
+void dstr_copy(struct dstr *dst, const char *array)
+{
+	dst->len = 0;
+	dstr_ncat(dst, array, strlen(array));
+}
+
+/* ------------------------------------------------------------------------- */
+/*
+ * JSON, enough for scene collection files. Integers are kept as ints and
+ * everything else as doubles, and arrays only hold objects, as with
+ * obs_data; other array elements are skipped.
+ */
+
+static void skip_space(struct json_reader *r)
+{
+	while (r->pos < r->end && (*r->pos == ' ' || *r->pos == '\t' ||
+			*r->pos == '\n' || *r->pos == '\r'))
+		r->pos++;
+}
+
+static bool expect_char(struct json_reader *r, char c)
+{
+	skip_space(r);
+	if (r->pos < r->end && *r->pos == c) {
+		r->pos++;
+		return true;
+	}
+
+	r->error = true;
+	return false;
+}
+
+static void put_utf8(struct dstr *str, unsigned long cp)
+{
+	char buf[4];
+	size_t len;
+
+	if (cp < 0x80) {
+		buf[0] = (char)cp;
+		len = 1;
+	} else if (cp < 0x800) {
+		buf[0] = (char)(0xC0 | (cp >> 6));
+		buf[1] = (char)(0x80 | (cp & 0x3F));
+		len = 2;
+	} else if (cp < 0x10000) {
+		buf[0] = (char)(0xE0 | (cp >> 12));
+		buf[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		buf[2] = (char)(0x80 | (cp & 0x3F));
+		len = 3;
+	} else {
+		buf[0] = (char)(0xF0 | (cp >> 18));
+		buf[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+		buf[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		buf[3] = (char)(0x80 | (cp & 0x3F));
+		len = 4;
+	}
+
+	dstr_ncat(str, buf, len);
+}
+
+static unsigned long read_hex4(struct json_reader *r)
+{
+	unsigned long cp = 0;
+
+	if (r->end - r->pos < 4) {
+		r->error = true;
+		return 0;
+	}
+
+	for (int i = 0; i < 4; i++) {
+		char c = *r->pos++;
+		cp <<= 4;
+		if (c >= '0' && c <= '9')
+			cp |= (unsigned long)(c - '0');
+		else if (c >= 'a' && c <= 'f')
+			cp |= (unsigned long)(c - 'a' + 10);
+		else if (c >= 'A' && c <= 'F')
+			cp |= (unsigned long)(c - 'A' + 10);
+		else
+			r->error = true;
+	}
+
+	return cp;
+}
+
+/* returns a bmalloc'd string */
+static char *read_string(struct json_reader *r)
+{
+	struct dstr str = {0};
+	const char *start;
+
+	if (!expect_char(r, '"'))
+		return NULL;
+
+	while (r->pos < r->end && *r->pos != '"' && !r->error) {
+		unsigned long cp;
+
+		start = r->pos;
+		while (r->pos < r->end && *r->pos != '"' && *r->pos != '\\')
+			r->pos++;
+		dstr_ncat(&str, start, (size_t)(r->pos - start));
+
+		if (r->pos >= r->end || *r->pos == '"')
+			break;
+
+		if (++r->pos >= r->end) {
+			r->error = true;
+			break;
+		}
+
+		switch (*r->pos++) {
+		case 'b': dstr_ncat(&str, "\b", 1); break;
+		case 'f': dstr_ncat(&str, "\f", 1); break;
+		case 'n': dstr_ncat(&str, "\n", 1); break;
+		case 'r': dstr_ncat(&str, "\r", 1); break;
+		case 't': dstr_ncat(&str, "\t", 1); break;
+		case 'u':
+			cp = read_hex4(r);
+			if (cp >= 0xD800 && cp < 0xDC00 && r->end - r->pos >= 6 &&
+					r->pos[0] == '\\' && r->pos[1] == 'u') {
+				r->pos += 2;
+				cp = 0x10000 + ((cp - 0xD800) << 10) +
+					(read_hex4(r) - 0xDC00);
+			}
+			put_utf8(&str, cp);
+			break;
+		default:
+			dstr_ncat(&str, r->pos - 1, 1);
+		}
+	}
+
+	if (!expect_char(r, '"') || r->error) {
+		dstr_free(&str);
+		return NULL;
+	}
+
+	return str.array ? str.array : bzalloc(1);
+}
+
+static bool read_literal(struct json_reader *r, const char *word)
+{
+	size_t len = strlen(word);
+
+	if ((size_t)(r->end - r->pos) < len || strncmp(r->pos, word, len) != 0)
+		return false;
+
+	r->pos += len;
+	return true;
+}
+
+static obs_data_t *read_object(struct json_reader *r, int depth);
+static void read_value(struct json_reader *r, obs_data_t *data,
+	const char *name, obs_data_array_t *array, int depth);
+
+static void read_array(struct json_reader *r, obs_data_t *data,
+	const char *name, int depth)
+{
+	obs_data_array_t *array = obs_data_array_create();
+
+	r->pos++;
+	skip_space(r);
+
+	if (r->pos < r->end && *r->pos == ']') {
+		r->pos++;
+	} else {
+		do {
+			read_value(r, NULL, NULL, array, depth + 1);
+			skip_space(r);
+		} while (!r->error && r->pos < r->end && *r->pos == ',' &&
+				++r->pos);
+		expect_char(r, ']');
+	}
+
+	if (data)
+		obs_data_set_array(data, name, array);
+	obs_data_array_release(array);
+}
+
+/*
+ * Reads one value into data[name], or appends it to array if it is an
+ * object; with neither the value is parsed and dropped.
+ */
+static void read_value(struct json_reader *r, obs_data_t *data,
+	const char *name, obs_data_array_t *array, int depth)
+{
+	obs_data_t *obj;
+	char *str;
+
+	skip_space(r);
+	if (r->pos >= r->end || depth > 64) {
+		r->error = true;
+		return;
+	}
+
+	switch (*r->pos) {
+	case '{':
+		obj = read_object(r, depth + 1);
+		if (obj && data)
+			obs_data_set_obj(data, name, obj);
+		else if (obj && array)
+			obs_data_array_push_back(array, obj);
+		obs_data_release(obj);
+		return;
+	case '[':
+		read_array(r, array ? NULL : data, name, depth);
+		return;
+	case '"':
+		str = read_string(r);
+		if (str && data)
+			obs_data_set_string(data, name, str);
+		bfree(str);
+		return;
+	}
+
+	if (read_literal(r, "true")) {
+		if (data)
+			obs_data_set_bool(data, name, true);
+	} else if (read_literal(r, "false")) {
+		if (data)
+			obs_data_set_bool(data, name, false);
+	} else if (read_literal(r, "null")) {
+		return;
+	} else {
+		char buf[64];
+		const char *start = r->pos;
+		size_t len;
+		bool integer = true;
+		char *end;
+
+		while (r->pos < r->end && strchr("+-0123456789.eE", *r->pos)) {
+			if (strchr(".eE", *r->pos))
+				integer = false;
+			r->pos++;
+		}
+
+		len = (size_t)(r->pos - start);
+		if (!len || len >= sizeof(buf)) {
+			r->error = true;
+			return;
+		}
+
+		memcpy(buf, start, len);
+		buf[len] = 0;
+
+		if (integer) {
+			long long val = strtoll(buf, &end, 10);
+			if (data)
+				obs_data_set_int(data, name, val);
+		} else {
+			double val = strtod(buf, &end);
+			if (data)
+				obs_data_set_double(data, name, val);
+		}
+
+		if (*end)
+			r->error = true;
+	}
+}
+
+static obs_data_t *read_object(struct json_reader *r, int depth)
+{
+	obs_data_t *data;
+
+	if (!expect_char(r, '{'))
+		return NULL;
+
+	data = obs_data_create();
+	skip_space(r);
+
+	if (r->pos < r->end && *r->pos == '}') {
+		r->pos++;
+		return data;
+	}
+
+	do {
+		char *name = read_string(r);
+
+		if (name && expect_char(r, ':'))
+			read_value(r, data, name, NULL, depth);
+		bfree(name);
+		skip_space(r);
+	} while (!r->error && r->pos < r->end && *r->pos == ',' && ++r->pos);
+
+	if (!expect_char(r, '}') || r->error) {
+		obs_data_release(data);
+		return NULL;
+	}
+
+	return data;
+}
+
+obs_data_t *obs_data_create_from_json(const char *json_string)
+{
+	struct json_reader r;
+	obs_data_t *data;
+
+	r.pos = json_string;
+	r.end = json_string + strlen(json_string);
+	r.error = false;
+
+	data = read_object(&r, 0);
+	skip_space(&r);
+	if (data && r.pos != r.end) {
+		obs_data_release(data);
+		data = NULL;
+	}
+
+	if (!data)
+		blog(LOG_ERROR, "invalid JSON near offset %zu",
+			(size_t)(r.pos - json_string));
+	return data;
+}
+
+obs_data_t *obs_data_create_from_json_file(const char *json_file)
+{
+	FILE *file = fopen(json_file, "rb");
+	obs_data_t *data = NULL;
+	char *json;
+	long len;
+
+	if (!file)
+		return NULL;
+
+	if (fseek(file, 0, SEEK_END) == 0 && (len = ftell(file)) >= 0 &&
+			fseek(file, 0, SEEK_SET) == 0) {
+		json = bmalloc((size_t)len + 1);
+		json[fread(json, 1, (size_t)len, file)] = 0;
+		data = obs_data_create_from_json(json);
+		bfree(json);
+	}
+
+	fclose(file);
+	return data;
+}
+
+/* ------------------------------------------------------------------------- */
+/* UI, hotkeys, frontend and locale: linked by the plugin, unused here */
+
+obs_hotkey_id obs_hotkey_register_frontend(const char *name,
+	const char *description, obs_hotkey_func func, void *data)
+{
+	UNUSED_PARAMETER(name);
+	UNUSED_PARAMETER(description);
+	UNUSED_PARAMETER(func);
+	UNUSED_PARAMETER(data);
+	return OBS_INVALID_HOTKEY_ID;
+}
+
+obs_hotkey_id obs_hotkey_register_source(obs_source_t *source,
+	const char *name, const char *description, obs_hotkey_func func,
+	void *data)
+{
+	UNUSED_PARAMETER(source);
+	return obs_hotkey_register_frontend(name, description, func, data);
+}
+
+void obs_hotkey_unregister(obs_hotkey_id id)
+{
+	UNUSED_PARAMETER(id);
+}
+
+void obs_hotkey_load(obs_hotkey_id id, obs_data_array_t *data)
+{
+	UNUSED_PARAMETER(id);
+	UNUSED_PARAMETER(data);
+}
+
+obs_data_array_t *obs_hotkey_save(obs_hotkey_id id)
+{
+	UNUSED_PARAMETER(id);
+	return NULL;
+}
+
+
+void dstr_replace(struct dstr *str, const char *find, const char *replace)
+{
+	UNUSED_PARAMETER(str);
+	UNUSED_PARAMETER(find);
+	UNUSED_PARAMETER(replace);
+}
+
+obs_properties_t *obs_properties_create(void)
+{
+	return NULL;
+}
+
+obs_property_t *obs_properties_get(obs_properties_t *props,
+	const char *property)
+{
+	UNUSED_PARAMETER(props);
+	UNUSED_PARAMETER(property);
+	return NULL;
+}
+
+obs_property_t *obs_properties_add_bool(obs_properties_t *props,
+	const char *name, const char *description)
+{
+	UNUSED_PARAMETER(props);
+	UNUSED_PARAMETER(name);
+	UNUSED_PARAMETER(description);
+	return NULL;
+}
+
+obs_property_t *obs_properties_add_int(obs_properties_t *props,
+	const char *name, const char *description, int min, int max, int step)
+{
+	UNUSED_PARAMETER(min);
+	UNUSED_PARAMETER(max);
+	UNUSED_PARAMETER(step);
+	return obs_properties_add_bool(props, name, description);
+}
+
+obs_property_t *obs_properties_add_float(obs_properties_t *props,
+	const char *name, const char *description, double min, double max,
+	double step)
+{
+	UNUSED_PARAMETER(min);
+	UNUSED_PARAMETER(max);
+	UNUSED_PARAMETER(step);
+	return obs_properties_add_bool(props, name, description);
+}
+
+obs_property_t *obs_properties_add_float_slider(obs_properties_t *props,
+	const char *name, const char *description, double min, double max,
+	double step)
+{
+	UNUSED_PARAMETER(min);
+	UNUSED_PARAMETER(max);
+	UNUSED_PARAMETER(step);
+	return obs_properties_add_bool(props, name, description);
+}
+
+obs_property_t *obs_properties_add_list(obs_properties_t *props,
+	const char *name, const char *description, enum obs_combo_type type,
+	enum obs_combo_format format)
+{
+	UNUSED_PARAMETER(type);
+	UNUSED_PARAMETER(format);
+	return obs_properties_add_bool(props, name, description);
+}
+
+obs_property_t *obs_properties_add_button(obs_properties_t *props,
+	const char *name, const char *text, obs_property_clicked_t callback)
+{
+	UNUSED_PARAMETER(callback);
+	return obs_properties_add_bool(props, name, text);
+}
+
+size_t obs_property_list_add_string(obs_property_t *p, const char *name,
+	const char *val)
+{
+	UNUSED_PARAMETER(p);
+	UNUSED_PARAMETER(name);
+	UNUSED_PARAMETER(val);
+	return 0;
+}
+
+size_t obs_property_list_add_int(obs_property_t *p, const char *name,
+	long long val)
+{
+	UNUSED_PARAMETER(p);
+	UNUSED_PARAMETER(name);
+	UNUSED_PARAMETER(val);
+	return 0;
+}
+
+void obs_property_set_visible(obs_property_t *p, bool visible)
+{
+	UNUSED_PARAMETER(p);
+	UNUSED_PARAMETER(visible);
+}
+
+void obs_property_set_modified_callback2(obs_property_t *p,
+	obs_property_modified2_t modified, void *priv)
+{
+	UNUSED_PARAMETER(p);
+	UNUSED_PARAMETER(modified);
+	UNUSED_PARAMETER(priv);
+}
+
+void obs_frontend_add_event_callback(obs_frontend_event_cb callback,
+	void *private_data)
+{
+	UNUSED_PARAMETER(callback);
+	UNUSED_PARAMETER(private_data);
+}
+
+void obs_frontend_remove_event_callback(obs_frontend_event_cb callback,
+	void *private_data)
+{
+	UNUSED_PARAMETER(callback);
+	UNUSED_PARAMETER(private_data);
+}
+
+obs_source_t *obs_frontend_get_current_scene(void)
+{
+	return NULL;
+}
+
+void obs_register_source_s(const struct obs_source_info *info, size_t size)
+{
+	UNUSED_PARAMETER(info);
+	UNUSED_PARAMETER(size);
+}
+
+lookup_t *obs_module_load_locale(obs_module_t *module,
+	const char *default_locale, const char *locale)
+{
+	UNUSED_PARAMETER(module);
+	UNUSED_PARAMETER(default_locale);
+	UNUSED_PARAMETER(locale);
+	return NULL;
+}
+
+bool text_lookup_getstr(lookup_t *lookup, const char *lookup_val,
+	const char **out)
+{
+	UNUSED_PARAMETER(lookup);
+	UNUSED_PARAMETER(lookup_val);
+	UNUSED_PARAMETER(out);
+	return false;
+}
+
+void text_lookup_destroy(lookup_t *lookup)
+{
+	UNUSED_PARAMETER(lookup);
+}
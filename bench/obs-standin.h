@@ -0,0 +1,76 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+#pragma once
+
+#include <obs-module.h>
+
+/*
+ * In-memory replacement for the parts of libobs the transition plan and
+ * the motion filter use. Scenes are plain linked lists of items, setters
+ * only store the value, settings are key/value lists that can be read
+ * from JSON, and bmalloc/bfree keep byte counters so the benchmark can
+ * report the plugin's heap use. UI, hotkey and frontend calls link but do
+ * nothing.
+ */
+
+struct standin_mem {
+	size_t              current;
+	size_t              peak;
+	long                allocs;
+};
+
+obs_source_t *standin_source_create(const char *name, uint32_t width,
+	uint32_t height);
+void standin_source_set_id(obs_source_t *source, const char *id);
+void standin_source_set_size(obs_source_t *source, uint32_t width,
+	uint32_t height);
+void standin_source_destroy(obs_source_t *source);
+
+/*
+ * A filter context attached to a scene's source. obs_source_update only
+ * marks the update as pending, as libobs defers it to the next video tick;
+ * the caller runs it when standin_source_take_update() says so.
+ */
+obs_source_t *standin_filter_create(obs_source_t *parent, const char *name,
+	obs_data_t *settings);
+bool standin_source_take_update(obs_source_t *source);
+
+/* a filter owned by the source, for what the plan looks at in a filter */
+obs_source_t *standin_source_add_filter(obs_source_t *source,
+	const char *id, uint32_t output_flags);
+
+obs_scene_t *standin_scene_create(void);
+obs_scene_t *standin_group_create(void);
+obs_source_t *standin_scene_source(obs_scene_t *scene, const char *name);
+obs_sceneitem_t *standin_scene_add(obs_scene_t *scene, obs_source_t *source,
+	const struct obs_transform_info *info);
+obs_scene_t *standin_scene_duplicate(obs_scene_t *scene);
+void standin_scene_destroy(obs_scene_t *scene);
+
+/* what obs_get_video_info reports, 1920x1080 at 60 fps by default */
+void standin_video_set(uint32_t width, uint32_t height, uint32_t fps);
+
+void standin_mem_get(struct standin_mem *mem);
+void standin_mem_reset_peak(void);
+
+uint64_t standin_setter_calls(void);
+uint64_t standin_draw_calls(void);
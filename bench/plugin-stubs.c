@@ -0,0 +1,138 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+/*
+ * The plugin's runtime services (stats, tracing, recording, external
+ * triggers) as no-ops, for tools that compile the plugin sources but only
+ * want their logic. The module boilerplate lives here too, since those
+ * tools do not link motion-effect.c.
+ */
+
+#include "../src/motion-runtime.h"
+#include "../src/motion-stats.h"
+#include "../src/motion-trace.h"
+#include "../src/motion-record.h"
+#include "../src/motion-trigger.h"
+
+OBS_DECLARE_MODULE()
+OBS_MODULE_USE_DEFAULT_LOCALE("motion-effect", "en-US")
+
+void motion_runtime_init(void) {}
+void motion_runtime_free(void) {}
+void motion_runtime_add_source(obs_source_t *source,
+	struct motion_stats *stats)
+{
+	UNUSED_PARAMETER(source);
+	UNUSED_PARAMETER(stats);
+}
+void motion_runtime_remove_source(struct motion_stats *stats)
+{
+	UNUSED_PARAMETER(stats);
+}
+void motion_runtime_add_evaluator(void *data, motion_eval_ready_t ready,
+	motion_eval_t eval)
+{
+	UNUSED_PARAMETER(data);
+	UNUSED_PARAMETER(ready);
+	UNUSED_PARAMETER(eval);
+}
+void motion_runtime_remove_evaluator(void *data) { UNUSED_PARAMETER(data); }
+
+bool motion_trace_active = false;
+
+void motion_trace_init(void) {}
+void motion_trace_free(void) {}
+void motion_trace_register(obs_source_t *source) { UNUSED_PARAMETER(source); }
+void motion_trace_event(const char *name, obs_source_t *source,
+	uint64_t start_ns, uint64_t end_ns)
+{
+	UNUSED_PARAMETER(name);
+	UNUSED_PARAMETER(source);
+	UNUSED_PARAMETER(start_ns);
+	UNUSED_PARAMETER(end_ns);
+}
+void motion_trace_instant(const char *name, obs_source_t *source)
+{
+	UNUSED_PARAMETER(name);
+	UNUSED_PARAMETER(source);
+}
+void motion_trace_frame(uint64_t frame_ns) { UNUSED_PARAMETER(frame_ns); }
+
+void motion_stat_record(struct motion_stat *stat, uint64_t value)
+{
+	UNUSED_PARAMETER(stat);
+	UNUSED_PARAMETER(value);
+}
+
+uint32_t motion_record_new_id(void) { return 0; }
+void motion_record_free(void) {}
+void motion_record_filter(uint32_t id, obs_source_t *source,
+	obs_data_t *settings, const struct motion_record_key *keys,
+	size_t num_keys)
+{
+	UNUSED_PARAMETER(id);
+	UNUSED_PARAMETER(source);
+	UNUSED_PARAMETER(settings);
+	UNUSED_PARAMETER(keys);
+	UNUSED_PARAMETER(num_keys);
+}
+void motion_record_trigger(uint32_t id, enum motion_trigger trigger,
+	bool forward, bool started, const struct motion_record_item *item)
+{
+	UNUSED_PARAMETER(id);
+	UNUSED_PARAMETER(trigger);
+	UNUSED_PARAMETER(forward);
+	UNUSED_PARAMETER(started);
+	UNUSED_PARAMETER(item);
+}
+void motion_record_tick(uint32_t id, float seconds, const float *values,
+	size_t num_values, uint64_t cost_ns)
+{
+	UNUSED_PARAMETER(id);
+	UNUSED_PARAMETER(seconds);
+	UNUSED_PARAMETER(values);
+	UNUSED_PARAMETER(num_values);
+	UNUSED_PARAMETER(cost_ns);
+}
+
+void motion_trigger_init(void) {}
+void motion_trigger_free(void) {}
+void motion_trigger_add_filter(obs_source_t *source,
+	motion_trigger_func func, motion_query_func query, void *data)
+{
+	UNUSED_PARAMETER(source);
+	UNUSED_PARAMETER(func);
+	UNUSED_PARAMETER(query);
+	UNUSED_PARAMETER(data);
+}
+void motion_trigger_remove_filter(void *data) { UNUSED_PARAMETER(data); }
+bool motion_trigger_defer(obs_source_t *source, motion_trigger_func func,
+	void *data, bool forward)
+{
+	UNUSED_PARAMETER(source);
+	func(data, forward);
+	return true;
+}
+void motion_trigger_notify(obs_source_t *source, enum motion_event event)
+{
+	UNUSED_PARAMETER(source);
+	UNUSED_PARAMETER(event);
+}
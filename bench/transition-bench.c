@@ -0,0 +1,413 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+/*
+ * End-to-end scaling benchmark for the transition plan. Builds synthetic
+ * A/B scenes against the in-memory libobs stand-in, runs full transitions
+ * through the same plan code the plugin uses, and prints the results as
+ * JSON on stdout:
+ *
+ *   transition-bench [--frames N] [--runs N] [--max-items N] [--serial]
+ *
+ * Each case reports setup latency (snapshot and plan build), per-frame
+ * cost, peak heap above the scenes themselves, and how many heap
+ * allocations the plan made on its first and on later transitions.
+ */
+
+#include "obs-standin.h"
+#include "../src/thread-pool.h"
+#include "../src/motion-transition/transition-plan.h"
+#include <util/platform.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CANVAS_WIDTH      1920
+#define CANVAS_HEIGHT     1080
+#define DEFAULT_FRAMES    60
+#define DEFAULT_RUNS      5
+#define DEFAULT_SMALL     16384.0f
+
+enum bench_mode {
+	MODE_DUPLICATE,
+	MODE_DIRECT
+};
+
+/*
+ * Item mix of one scene pair: the share of items present in both scenes
+ * with the same transform type (they move), present in both with a
+ * different type (they zoom out and in), and the rest unique to one scene.
+ */
+struct bench_mix {
+	const char          *name;
+	double              shared_same;
+	double              shared_diff;
+};
+
+struct bench_scenes {
+	obs_scene_t         *scene_a;
+	obs_scene_t         *scene_b;
+	obs_source_t        **sources;
+	size_t              num_sources;
+};
+
+struct bench_result {
+	uint64_t            setup_min;
+	uint64_t            setup_sum;
+	uint64_t            duplicate_sum;
+	uint64_t            frame_sum;
+	uint64_t            frame_max;
+	uint64_t            setters;
+	uint64_t            draws;
+	size_t              peak_bytes;
+	long                first_allocs;
+	long                steady_allocs;
+};
+
+static const struct bench_mix mixes[] = {
+	{"mostly_shared", 0.8, 0.1},
+	{"half_shared",   0.4, 0.1},
+	{"disjoint",      0.0, 0.0},
+};
+
+static const size_t sizes[] = {10, 100, 500, 1000, 2500, 5000};
+
+static uint32_t rand_state = 1;
+
+static uint32_t next_rand(void)
+{
+	rand_state = rand_state * 1664525u + 1013904223u;
+	return rand_state >> 8;
+}
+
+static float rand_range(float min, float max)
+{
+	return min + (max - min) * (float)(next_rand() & 0xffff) / 65535.0f;
+}
+
+static void random_info(struct obs_transform_info *info, bool bounded)
+{
+	memset(info, 0, sizeof(*info));
+
+	/* roughly one in ten items starts off-canvas */
+	if ((next_rand() % 10) == 0)
+		vec2_set(&info->pos, rand_range(-2000.0f, -700.0f),
+			rand_range(0.0f, CANVAS_HEIGHT));
+	else
+		vec2_set(&info->pos, rand_range(0.0f, CANVAS_WIDTH),
+			rand_range(0.0f, CANVAS_HEIGHT));
+
+	vec2_set(&info->scale, rand_range(0.25f, 1.5f), rand_range(0.25f, 1.5f));
+	info->rot = (next_rand() % 4) == 0 ? rand_range(-45.0f, 45.0f) : 0.0f;
+	info->alignment = OBS_ALIGN_LEFT | OBS_ALIGN_TOP;
+	info->bounds_alignment = OBS_ALIGN_CENTER;
+
+	if (bounded) {
+		info->bounds_type = OBS_BOUNDS_SCALE_INNER;
+		vec2_set(&info->bounds, rand_range(64.0f, 640.0f),
+			rand_range(64.0f, 360.0f));
+	} else {
+		info->bounds_type = OBS_BOUNDS_NONE;
+	}
+}
+
+static obs_source_t *add_source(struct bench_scenes *scenes, const char *name)
+{
+	obs_source_t *source = standin_source_create(name,
+		(uint32_t)rand_range(16.0f, 640.0f),
+		(uint32_t)rand_range(16.0f, 360.0f));
+	scenes->sources[scenes->num_sources++] = source;
+	return source;
+}
+
+static void create_scenes(struct bench_scenes *scenes, size_t count,
+	const struct bench_mix *mix)
+{
+	size_t num_same = (size_t)(count * mix->shared_same);
+	size_t num_diff = (size_t)(count * mix->shared_diff);
+	size_t num_shared = num_same + num_diff;
+	size_t *order = bmalloc(sizeof(size_t) * (num_shared ? num_shared : 1));
+	char name[64];
+
+	rand_state = (uint32_t)count * 31u + 7u;
+
+	scenes->scene_a = standin_scene_create();
+	scenes->scene_b = standin_scene_create();
+	scenes->sources = bzalloc(sizeof(obs_source_t*) * count * 2);
+	scenes->num_sources = 0;
+
+	for (size_t i = 0; i < num_shared; i++) {
+		struct obs_transform_info info;
+		snprintf(name, sizeof(name), "shared-%zu", i);
+		add_source(scenes, name);
+		random_info(&info, false);
+		standin_scene_add(scenes->scene_a, scenes->sources[i], &info);
+		order[i] = i;
+	}
+
+	/* shared items appear in B in a different z-order */
+	for (size_t i = num_shared; i > 1; i--) {
+		size_t j = next_rand() % i;
+		size_t tmp = order[i - 1];
+		order[i - 1] = order[j];
+		order[j] = tmp;
+	}
+
+	for (size_t i = 0; i < num_shared; i++) {
+		struct obs_transform_info info;
+		random_info(&info, order[i] >= num_same);
+		standin_scene_add(scenes->scene_b, scenes->sources[order[i]],
+			&info);
+	}
+
+	for (size_t i = num_shared; i < count; i++) {
+		struct obs_transform_info info;
+
+		snprintf(name, sizeof(name), "a-%zu", i);
+		random_info(&info, false);
+		standin_scene_add(scenes->scene_a, add_source(scenes, name),
+			&info);
+
+		snprintf(name, sizeof(name), "b-%zu", i);
+		random_info(&info, false);
+		standin_scene_add(scenes->scene_b, add_source(scenes, name),
+			&info);
+	}
+
+	bfree(order);
+}
+
+static void destroy_scenes(struct bench_scenes *scenes)
+{
+	standin_scene_destroy(scenes->scene_a);
+	standin_scene_destroy(scenes->scene_b);
+
+	for (size_t i = 0; i < scenes->num_sources; i++)
+		standin_source_destroy(scenes->sources[i]);
+	bfree(scenes->sources);
+}
+
+/*
+ * One full transition, laid out like motion_transition_video_render: the
+ * scenes are duplicated unless drawing directly, the plan is built, and
+ * every frame renders the out scene up to the midpoint, then the in scene.
+ */
+static void run_transition(struct bench_scenes *scenes, transition_plan_t *plan,
+	enum bench_mode mode, size_t frames, struct bench_result *result,
+	long *allocs)
+{
+	struct standin_mem mem_start, mem_end;
+	uint64_t start, setup_end, dup_ns = 0;
+	obs_scene_t *scene_a = scenes->scene_a;
+	obs_scene_t *scene_b = scenes->scene_b;
+
+	if (mode == MODE_DUPLICATE) {
+		uint64_t dup_start = os_gettime_ns();
+		scene_a = standin_scene_duplicate(scene_a);
+		scene_b = standin_scene_duplicate(scene_b);
+		dup_ns = os_gettime_ns() - dup_start;
+	}
+
+	standin_mem_get(&mem_start);
+	start = os_gettime_ns();
+
+	plan->out_list.scene = scene_a;
+	plan->in_list.scene = scene_b;
+	plan->direct_render = mode == MODE_DIRECT;
+	snapshot_scenes(plan);
+	create_item_list(plan);
+
+	setup_end = os_gettime_ns();
+
+	for (size_t f = 0; f < frames; f++) {
+		float t = (float)(f + 1) / (float)(frames + 1);
+		list_info_t *list = t <= 0.5f ? &plan->out_list :
+			&plan->in_list;
+		uint64_t touched = 0, setters = 0;
+		uint64_t frame_start = os_gettime_ns();
+		uint64_t frame_ns;
+
+		evaluate_items(plan, list, t, TIER_FULL, (uint32_t)f);
+		if (mode == MODE_DIRECT)
+			render_items(plan, list, &touched);
+		else
+			commit_items(plan, list, TIER_FULL, &touched, &setters);
+
+		frame_ns = os_gettime_ns() - frame_start;
+		result->frame_sum += frame_ns;
+		if (frame_ns > result->frame_max)
+			result->frame_max = frame_ns;
+	}
+
+	release_plan(plan);
+
+	standin_mem_get(&mem_end);
+	*allocs = mem_end.allocs - mem_start.allocs;
+
+	if (mode == MODE_DUPLICATE) {
+		standin_scene_destroy(scene_a);
+		standin_scene_destroy(scene_b);
+	}
+
+	if (!result->setup_min || setup_end - start < result->setup_min)
+		result->setup_min = setup_end - start;
+	result->setup_sum += setup_end - start;
+	result->duplicate_sum += dup_ns;
+}
+
+static void run_case(size_t count, const struct bench_mix *mix,
+	enum bench_mode mode, size_t frames, size_t runs,
+	struct bench_result *result)
+{
+	struct bench_scenes scenes;
+	transition_plan_t plan;
+	struct standin_mem mem_start, mem_end;
+	uint64_t setters, draws;
+
+	memset(result, 0, sizeof(*result));
+	memset(&plan, 0, sizeof(plan));
+	plan.acc_x = 0.5f;
+	plan.acc_y = 0.5f;
+	plan.small_area = DEFAULT_SMALL;
+
+	create_scenes(&scenes, count, mix);
+	standin_mem_reset_peak();
+	standin_mem_get(&mem_start);
+
+	setters = standin_setter_calls();
+	draws = standin_draw_calls();
+
+	for (size_t run = 0; run < runs; run++) {
+		long allocs;
+		run_transition(&scenes, &plan, mode, frames, result, &allocs);
+		if (run == 0)
+			result->first_allocs = allocs;
+		else if (allocs > result->steady_allocs)
+			result->steady_allocs = allocs;
+	}
+
+	result->setters = standin_setter_calls() - setters;
+	result->draws = standin_draw_calls() - draws;
+
+	arena_free(&plan.arena);
+
+	standin_mem_get(&mem_end);
+	result->peak_bytes = mem_end.peak - mem_start.current;
+
+	destroy_scenes(&scenes);
+}
+
+static void print_result(size_t count, const struct bench_mix *mix,
+	enum bench_mode mode, size_t frames, size_t runs,
+	const struct bench_result *r, bool first)
+{
+	printf("%s\n\t\t{\"items\": %zu, \"mix\": \"%s\", \"mode\": \"%s\", "
+		"\"setup_ns\": {\"min\": %llu, \"mean\": %llu}, "
+		"\"duplicate_ns\": %llu, "
+		"\"frame_ns\": {\"mean\": %llu, \"max\": %llu}, "
+		"\"setters_per_frame\": %.1f, \"draws_per_frame\": %.1f, "
+		"\"peak_bytes\": %zu, "
+		"\"plan_allocs\": {\"first\": %ld, \"steady\": %ld}}",
+		first ? "" : ",", count, mix->name,
+		mode == MODE_DIRECT ? "direct" : "duplicate",
+		(unsigned long long)r->setup_min,
+		(unsigned long long)(r->setup_sum / runs),
+		(unsigned long long)(r->duplicate_sum / runs),
+		(unsigned long long)(r->frame_sum / (frames * runs)),
+		(unsigned long long)r->frame_max,
+		(double)r->setters / (double)(frames * runs),
+		(double)r->draws / (double)(frames * runs),
+		r->peak_bytes, r->first_allocs, r->steady_allocs);
+}
+
+static size_t arg_value(int argc, char **argv, int *i)
+{
+	long value;
+
+	if (*i + 1 >= argc) {
+		fprintf(stderr, "missing value for %s\n", argv[*i]);
+		exit(1);
+	}
+
+	value = atol(argv[++(*i)]);
+	if (value <= 0) {
+		fprintf(stderr, "invalid value for %s\n", argv[*i - 1]);
+		exit(1);
+	}
+
+	return (size_t)value;
+}
+
+int main(int argc, char **argv)
+{
+	size_t frames = DEFAULT_FRAMES;
+	size_t runs = DEFAULT_RUNS;
+	size_t max_items = (size_t)-1;
+	bool serial = false;
+	bool first = true;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--frames") == 0) {
+			frames = arg_value(argc, argv, &i);
+		} else if (strcmp(argv[i], "--runs") == 0) {
+			runs = arg_value(argc, argv, &i);
+		} else if (strcmp(argv[i], "--max-items") == 0) {
+			max_items = arg_value(argc, argv, &i);
+		} else if (strcmp(argv[i], "--serial") == 0) {
+			serial = true;
+		} else {
+			fprintf(stderr, "usage: %s [--frames N] [--runs N] "
+				"[--max-items N] [--serial]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (!serial)
+		thread_pool_init();
+
+	printf("{\n\t\"frames\": %zu,\n\t\"runs\": %zu,\n"
+		"\t\"logical_cores\": %d,\n\t\"parallel_plan\": %s,\n"
+		"\t\"results\": [", frames, runs, os_get_logical_cores(),
+		serial ? "false" : "true");
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		if (sizes[s] > max_items)
+			break;
+
+		for (size_t m = 0; m < sizeof(mixes) / sizeof(mixes[0]); m++) {
+			for (int mode = MODE_DUPLICATE; mode <= MODE_DIRECT;
+					mode++) {
+				struct bench_result result;
+				run_case(sizes[s], &mixes[m], mode, frames,
+					runs, &result);
+				print_result(sizes[s], &mixes[m], mode, frames,
+					runs, &result, first);
+				fflush(stdout);
+				first = false;
+			}
+		}
+	}
+
+	printf("\n\t]\n}\n");
+
+	if (!serial)
+		thread_pool_free();
+	return 0;
+}
@@ -0,0 +1,106 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#include "arena.h"
+
+#define ARENA_ALIGN       32
+#define ARENA_MIN_BLOCK   (16 * 1024)
+
+struct arena_block {
+	struct arena_block  *prev;
+	size_t              size;
+};
+
+static inline size_t align_size(size_t size)
+{
+	return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static inline uint8_t *block_data(struct arena_block *block)
+{
+	return (uint8_t*)block + align_size(sizeof(struct arena_block));
+}
+
+static struct arena_block *new_block(struct arena *arena, size_t size,
+	struct arena_block *prev)
+{
+	struct arena_block *block = bmalloc(
+		align_size(sizeof(struct arena_block)) + size);
+	block->prev = prev;
+	block->size = size;
+	arena->heap_allocs++;
+	return block;
+}
+
+void *arena_alloc(struct arena *arena, size_t size)
+{
+	uint8_t *ptr;
+
+	size = align_size(size ? size : 1);
+
+	if (!arena->block || arena->used + size > arena->block->size) {
+		size_t block_size = arena->block ? arena->block->size * 2 :
+			ARENA_MIN_BLOCK;
+		while (block_size < size)
+			block_size *= 2;
+
+		arena->block = new_block(arena, block_size, arena->block);
+		arena->used = 0;
+	}
+
+	ptr = block_data(arena->block) + arena->used;
+	arena->used += size;
+	memset(ptr, 0, size);
+	return ptr;
+}
+
+void arena_reset(struct arena *arena)
+{
+	struct arena_block *block = arena->block;
+	size_t total = 0;
+
+	arena->used = 0;
+
+	if (!block || !block->prev)
+		return;
+
+	while (block) {
+		struct arena_block *prev = block->prev;
+		total += block->size;
+		bfree(block);
+		block = prev;
+	}
+
+	arena->block = new_block(arena, total, NULL);
+}
+
+void arena_free(struct arena *arena)
+{
+	struct arena_block *block = arena->block;
+
+	while (block) {
+		struct arena_block *prev = block->prev;
+		bfree(block);
+		block = prev;
+	}
+
+	arena->block = NULL;
+	arena->used = 0;
+}
@@ -0,0 +1,43 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#pragma once
+
+#include <obs-module.h>
+
+/*
+ * Bump allocator for memory that lives and dies together. Allocations are
+ * zeroed and never freed one by one; arena_reset() drops them all at once.
+ * When a round outgrows the current block, extra blocks are chained, and
+ * the next reset folds them into one block big enough for that round, so
+ * a steady workload stops allocating after its first pass.
+ */
+
+struct arena_block;
+
+struct arena {
+	struct arena_block  *block;
+	size_t              used;
+	long                heap_allocs;
+};
+
+void *arena_alloc(struct arena *arena, size_t size);
+void arena_reset(struct arena *arena);
+void arena_free(struct arena *arena);
@@ -0,0 +1,216 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#include "epoch.h"
+#include <util/threading.h>
+#include <limits.h>
+
+#ifdef _MSC_VER
+#include <windows.h>
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+#define EPOCH_SLOTS 64
+
+struct retired {
+	struct retired      *next;
+	void                *ptr;
+	epoch_destroy_t     destroy;
+	long                epoch;
+};
+
+/* 0 in a slot means its thread is outside any read section */
+static volatile long global_epoch = 1;
+static volatile long slots[EPOCH_SLOTS];
+static volatile long next_slot;
+
+/* threads past the slot table share a counter; while it is non-zero
+ * nothing is reclaimed */
+static volatile long overflow_readers;
+
+static pthread_mutex_t retired_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct retired *retired_list;
+
+static THREAD_LOCAL long thread_slot;
+static THREAD_LOCAL long thread_depth;
+static THREAD_LOCAL long thread_epoch;
+
+void *epoch_load(void *volatile *ptr)
+{
+#ifdef _MSC_VER
+	return InterlockedCompareExchangePointer(ptr, NULL, NULL);
+#else
+	return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+#endif
+}
+
+void *epoch_exchange(void *volatile *ptr, void *value)
+{
+#ifdef _MSC_VER
+	return InterlockedExchangePointer(ptr, value);
+#else
+	return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline long get_slot(void)
+{
+	if (!thread_slot) {
+		long slot = os_atomic_inc_long(&next_slot);
+		thread_slot = slot <= EPOCH_SLOTS ? slot : -1;
+	}
+	return thread_slot;
+}
+
+/*
+ * The slot is published with a full barrier before the caller loads any
+ * shared pointer, so a reclaim either sees the slot or the reader sees
+ * the pointer that replaced the retired one.
+ */
+void epoch_enter(void)
+{
+	long slot;
+
+	if (thread_depth++)
+		return;
+
+	slot = get_slot();
+	if (slot < 0) {
+		os_atomic_inc_long(&overflow_readers);
+		return;
+	}
+
+	thread_epoch = os_atomic_load_long(&global_epoch);
+	os_atomic_compare_swap_long(&slots[slot - 1], 0, thread_epoch);
+}
+
+void epoch_leave(void)
+{
+	long slot;
+
+	if (--thread_depth)
+		return;
+
+	slot = thread_slot;
+	if (slot < 0)
+		os_atomic_dec_long(&overflow_readers);
+	else
+		os_atomic_compare_swap_long(&slots[slot - 1], thread_epoch, 0);
+}
+
+/* oldest epoch a reader may still be in, or 0 if none may be freed */
+static long oldest_reader(void)
+{
+	long oldest = LONG_MAX;
+	long count = os_atomic_load_long(&next_slot);
+
+	if (os_atomic_load_long(&overflow_readers))
+		return 0;
+
+	if (count > EPOCH_SLOTS)
+		count = EPOCH_SLOTS;
+
+	for (long i = 0; i < count; i++) {
+		long epoch = os_atomic_load_long(&slots[i]);
+		if (epoch && epoch < oldest)
+			oldest = epoch;
+	}
+
+	return oldest;
+}
+
+void epoch_reclaim(void)
+{
+	struct retired *done = NULL;
+	struct retired **prev;
+	long oldest;
+
+	pthread_mutex_lock(&retired_mutex);
+
+	if (!retired_list) {
+		pthread_mutex_unlock(&retired_mutex);
+		return;
+	}
+
+	/* readers entering from here on can't reach anything retired */
+	os_atomic_inc_long(&global_epoch);
+	oldest = oldest_reader();
+
+	prev = &retired_list;
+	while (*prev) {
+		struct retired *entry = *prev;
+
+		if (entry->epoch < oldest) {
+			*prev = entry->next;
+			entry->next = done;
+			done = entry;
+		} else {
+			prev = &entry->next;
+		}
+	}
+
+	pthread_mutex_unlock(&retired_mutex);
+
+	while (done) {
+		struct retired *next = done->next;
+		done->destroy(done->ptr);
+		bfree(done);
+		done = next;
+	}
+}
+
+void epoch_retire(void *ptr, epoch_destroy_t destroy)
+{
+	struct retired *entry;
+
+	if (!ptr)
+		return;
+
+	entry = bzalloc(sizeof(*entry));
+	entry->ptr = ptr;
+	entry->destroy = destroy;
+
+	pthread_mutex_lock(&retired_mutex);
+	entry->epoch = os_atomic_load_long(&global_epoch);
+	entry->next = retired_list;
+	retired_list = entry;
+	pthread_mutex_unlock(&retired_mutex);
+
+	epoch_reclaim();
+}
+
+void epoch_free(void)
+{
+	struct retired *entry;
+
+	pthread_mutex_lock(&retired_mutex);
+	entry = retired_list;
+	retired_list = NULL;
+	pthread_mutex_unlock(&retired_mutex);
+
+	while (entry) {
+		struct retired *next = entry->next;
+		entry->destroy(entry->ptr);
+		bfree(entry);
+		entry = next;
+	}
+}
@@ -0,0 +1,48 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#pragma once
+
+#include <obs-module.h>
+
+/*
+ * Epoch-based reclamation for objects that render and audio threads read
+ * while another thread replaces them. Readers bracket their use with
+ * epoch_enter() and epoch_leave(), which only write a per-thread slot and
+ * never block; sections may nest. A writer swaps the shared pointer with
+ * epoch_exchange() and hands the old object to epoch_retire(), which
+ * frees it once every reader that could still see it has left. Nothing
+ * waits for readers: retired objects are freed by epoch_reclaim(), run by
+ * the runtime once per frame and by every retire.
+ */
+
+typedef void (*epoch_destroy_t)(void *ptr);
+
+void *epoch_load(void *volatile *ptr);
+void *epoch_exchange(void *volatile *ptr, void *value);
+
+void epoch_enter(void);
+void epoch_leave(void);
+
+void epoch_retire(void *ptr, epoch_destroy_t destroy);
+void epoch_reclaim(void);
+
+/* frees everything still retired; only once no reader can be left */
+void epoch_free(void);
@@ -21,6 +21,8 @@
 #include "helper.h"
 #include <obs-scene.h>
 #include <util/dstr.h>
+#include <graphics/math-defs.h>
+#include <math.h>
 
 
 obs_sceneitem_t *get_item(obs_source_t *context,
@@ -206,4 +208,209 @@ void crop_linear(struct obs_sceneitem_crop a, struct obs_sceneitem_crop b,
 	result->left = (1.0f - t) * a.left + t * b.left;
 	result->top = (1.0f - t) * a.top + t * b.top;
 	result->right = (1.0f - t) * a.right + t * b.right;
-}
\ No newline at end of file
+}
+
+/*
+ * Damped spring in closed form. With x0 and v0 the offset from the target
+ * and the velocity at t = 0, the offset at time t is
+ *
+ *   decay(t) * (a * c(t) + b * s(t))
+ *
+ * where c = cos(omega_d t), s = sin(omega_d t) when underdamped and c = 1,
+ * s = t when critically damped. The time terms are shared by every value
+ * moved by the same spring, so each value costs two multiply-adds.
+ */
+
+void spring_init(struct spring *spring, float frequency, float damping)
+{
+	spring->omega = 2.0f * (float)M_PI * frequency;
+	spring->zeta = damping < 1.0f ? damping : 1.0f;
+	spring->omega_d = spring->omega *
+		sqrtf(1.0f - spring->zeta * spring->zeta);
+}
+
+void spring_coefficients(const struct spring *spring, float x0, float v0,
+	float *a, float *b)
+{
+	*a = x0;
+	if (spring->omega_d > 0.0f)
+		*b = (v0 + spring->zeta * spring->omega * x0) / spring->omega_d;
+	else
+		*b = v0 + spring->omega * x0;
+}
+
+void spring_eval_frame(const struct spring *spring, float t,
+	struct spring_frame *frame)
+{
+	float k = spring->zeta * spring->omega;
+
+	frame->decay = expf(-k * t);
+
+	if (spring->omega_d > 0.0f) {
+		float c = cosf(spring->omega_d * t);
+		float s = sinf(spring->omega_d * t);
+		frame->c = c;
+		frame->s = s;
+		frame->dc = -spring->omega_d * s - k * c;
+		frame->ds = spring->omega_d * c - k * s;
+	} else {
+		frame->c = 1.0f;
+		frame->s = t;
+		frame->dc = -k;
+		frame->ds = 1.0f - k * t;
+	}
+}
+
+/*
+ * First time after which the offset stays within eps, from the envelope
+ * of the motion.
+ */
+
+float spring_settle_time(const struct spring *spring, float a, float b,
+	float eps)
+{
+	float k = spring->zeta * spring->omega;
+	float t = 0.0f;
+
+	if (k <= 0.0f || eps <= 0.0f)
+		return 0.0f;
+
+	if (spring->omega_d > 0.0f) {
+		float amp = sqrtf(a * a + b * b);
+		return amp > eps ? logf(amp / eps) / k : 0.0f;
+	}
+
+	/* (|a| + |b| t) e^(-k t) = eps, by fixed-point iteration */
+	for (int i = 0; i < 16; i++) {
+		float amp = fabsf(a) + fabsf(b) * t;
+		float next = amp > eps ? logf(amp / eps) / k : 0.0f;
+		if (fabsf(next - t) < 0.0001f)
+			return next;
+		t = next;
+	}
+
+	return t;
+}
+
+/*
+ * Canvas-space bounding box of an item: the corners of its cropped size
+ * put through the draw transform, so flips, bounds alignment and overflow
+ * of an outer-scaled item land where libobs draws them.
+ * Returns false if the item has no visible area.
+ */
+
+bool get_item_bbox(const struct obs_transform_info *info,
+	const struct obs_sceneitem_crop *crop, float base_width,
+	float base_height, struct vec2 *min, struct vec2 *max)
+{
+	float width = base_width - (float)(crop->left + crop->right);
+	float height = base_height - (float)(crop->top + crop->bottom);
+	struct matrix4 m;
+
+	if (width <= 0.0f || height <= 0.0f)
+		return false;
+
+	get_item_draw_transform(info, width, height, &m);
+
+	for (int i = 0; i < 4; i++) {
+		float x = (i & 1) ? width : 0.0f;
+		float y = (i & 2) ? height : 0.0f;
+		float rx = x * m.x.x + y * m.y.x + m.t.x;
+		float ry = x * m.x.y + y * m.y.y + m.t.y;
+
+		if (i == 0 || rx < min->x)
+			min->x = rx;
+		if (i == 0 || ry < min->y)
+			min->y = ry;
+		if (i == 0 || rx > max->x)
+			max->x = rx;
+		if (i == 0 || ry > max->y)
+			max->y = ry;
+	}
+
+	return max->x > min->x && max->y > min->y;
+}
+
+static inline void add_alignment(struct vec2 *v, uint32_t align, float cx,
+	float cy)
+{
+	if (align & OBS_ALIGN_RIGHT)
+		v->x += cx;
+	else if ((align & OBS_ALIGN_LEFT) == 0)
+		v->x += cx / 2.0f;
+
+	if (align & OBS_ALIGN_BOTTOM)
+		v->y += cy;
+	else if ((align & OBS_ALIGN_TOP) == 0)
+		v->y += cy / 2.0f;
+}
+
+/*
+ * Rebuilds the matrix libobs would use to draw an uncropped item with the
+ * given transform, so an item can be rendered without writing the
+ * transform back to the scene item.
+ */
+
+void get_item_draw_transform(const struct obs_transform_info *info,
+	float width, float height, struct matrix4 *draw_transform)
+{
+	struct vec2 origin = { 0.0f, 0.0f };
+	struct vec2 scale = info->scale;
+	float cx = width;
+	float cy = height;
+
+	if (info->bounds_type != OBS_BOUNDS_NONE && width > 0.0f &&
+			height > 0.0f) {
+		enum obs_bounds_type bounds_type = info->bounds_type;
+		float item_w = width * fabsf(scale.x);
+		float item_h = height * fabsf(scale.y);
+
+		if (bounds_type == OBS_BOUNDS_MAX_ONLY &&
+				(item_w > info->bounds.x || item_h > info->bounds.y))
+			bounds_type = OBS_BOUNDS_SCALE_INNER;
+
+		if (bounds_type == OBS_BOUNDS_SCALE_INNER ||
+				bounds_type == OBS_BOUNDS_SCALE_OUTER) {
+			bool use_width = info->bounds.x / info->bounds.y <
+				item_w / item_h;
+			float mul;
+
+			if (bounds_type == OBS_BOUNDS_SCALE_OUTER)
+				use_width = !use_width;
+
+			mul = use_width ? info->bounds.x / item_w :
+				info->bounds.y / item_h;
+			scale.x *= mul;
+			scale.y *= mul;
+		} else if (bounds_type == OBS_BOUNDS_SCALE_TO_WIDTH) {
+			scale.x *= info->bounds.x / item_w;
+			scale.y *= info->bounds.x / item_w;
+		} else if (bounds_type == OBS_BOUNDS_SCALE_TO_HEIGHT) {
+			scale.x *= info->bounds.y / item_h;
+			scale.y *= info->bounds.y / item_h;
+		} else if (bounds_type == OBS_BOUNDS_STRETCH) {
+			scale.x = info->bounds.x / width;
+			scale.y = info->bounds.y / height;
+		}
+
+		add_alignment(&origin, info->bounds_alignment,
+			-(info->bounds.x - width * scale.x),
+			-(info->bounds.y - height * scale.y));
+		cx = info->bounds.x;
+		cy = info->bounds.y;
+	} else {
+		cx *= scale.x;
+		cy *= scale.y;
+	}
+
+	add_alignment(&origin, info->alignment, cx, cy);
+
+	matrix4_identity(draw_transform);
+	matrix4_scale3f(draw_transform, draw_transform, scale.x, scale.y, 1.0f);
+	matrix4_translate3f(draw_transform, draw_transform, -origin.x,
+		-origin.y, 0.0f);
+	matrix4_rotate_aa4f(draw_transform, draw_transform, 0.0f, 0.0f, 1.0f,
+		RAD(info->rot));
+	matrix4_translate3f(draw_transform, draw_transform, info->pos.x,
+		info->pos.y, 0.0f);
+}
@@ -57,4 +57,36 @@ void vec_bezier(struct vec2 a, struct vec2 b, struct vec2 c,
 	struct vec2 *result, float t);
 
 void crop_linear(struct obs_sceneitem_crop a, struct obs_sceneitem_crop b,
-	struct obs_sceneitem_crop* result, float t);
\ No newline at end of file
+	struct obs_sceneitem_crop* result, float t);
+
+struct spring {
+	float omega;
+	float zeta;
+	float omega_d;
+};
+
+struct spring_frame {
+	float decay;
+	float c;
+	float s;
+	float dc;
+	float ds;
+};
+
+void spring_init(struct spring *spring, float frequency, float damping);
+
+void spring_coefficients(const struct spring *spring, float x0, float v0,
+	float *a, float *b);
+
+void spring_eval_frame(const struct spring *spring, float t,
+	struct spring_frame *frame);
+
+float spring_settle_time(const struct spring *spring, float a, float b,
+	float eps);
+
+bool get_item_bbox(const struct obs_transform_info *info,
+	const struct obs_sceneitem_crop *crop, float base_width,
+	float base_height, struct vec2 *min, struct vec2 *max);
+
+void get_item_draw_transform(const struct obs_transform_info *info,
+	float width, float height, struct matrix4 *draw_transform);
@@ -0,0 +1,642 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#include "motion-control.h"
+#include "motion-trigger.h"
+#include "motion-runtime.h"
+
+#define CONTROL_ENV "MOTION_EFFECT_CONTROL"
+
+#ifdef _WIN32
+
+void motion_control_init(void)
+{
+	if (getenv(CONTROL_ENV))
+		blog(LOG_WARNING, "[motion-effect] the control socket is not "
+			"available on Windows");
+}
+
+void motion_control_free(void)
+{
+}
+
+#else
+
+#include <util/platform.h>
+#include <util/threading.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+#define MAX_CLIENTS      8
+#define HEADER_SIZE      9
+#define SEND_TIMEOUT_SEC 1
+
+struct message {
+	uint8_t             *data;
+	size_t              size;
+	size_t              capacity;
+};
+
+struct reader {
+	const uint8_t       *data;
+	size_t              size;
+	size_t              pos;
+	bool                error;
+};
+
+struct client {
+	int                 fd;
+	uint8_t             *buffer;
+	size_t              size;
+};
+
+static struct client clients[MAX_CLIENTS];
+static pthread_t server_thread;
+static int listen_fd = -1;
+static int wake_pipe[2] = {-1, -1};
+static char *socket_path;
+static bool running;
+
+/* ------------------------------------------------------------------------- */
+/* encoding */
+
+static void put_bytes(struct message *msg, const void *bytes, size_t size)
+{
+	if (msg->size + size > msg->capacity) {
+		size_t capacity = msg->capacity ? msg->capacity : 256;
+
+		while (msg->size + size > capacity)
+			capacity *= 2;
+		msg->data = brealloc(msg->data, capacity);
+		msg->capacity = capacity;
+	}
+
+	memcpy(msg->data + msg->size, bytes, size);
+	msg->size += size;
+}
+
+static void put_uint(struct message *msg, uint64_t value, size_t size)
+{
+	uint8_t bytes[8];
+
+	for (size_t i = 0; i < size; i++)
+		bytes[i] = (uint8_t)(value >> (i * 8));
+	put_bytes(msg, bytes, size);
+}
+
+static inline void put_u8(struct message *msg, uint8_t value)
+{
+	put_uint(msg, value, 1);
+}
+
+static inline void put_u16(struct message *msg, uint16_t value)
+{
+	put_uint(msg, value, 2);
+}
+
+static inline void put_u32(struct message *msg, uint32_t value)
+{
+	put_uint(msg, value, 4);
+}
+
+static inline void put_u64(struct message *msg, uint64_t value)
+{
+	put_uint(msg, value, 8);
+}
+
+static void put_f32(struct message *msg, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	put_u32(msg, bits);
+}
+
+static void put_str(struct message *msg, const char *str)
+{
+	size_t len = str ? strlen(str) : 0;
+
+	if (len > 0xFFFF)
+		len = 0xFFFF;
+	put_u16(msg, (uint16_t)len);
+	put_bytes(msg, str, len);
+}
+
+static void set_u16(struct message *msg, size_t pos, uint16_t value)
+{
+	msg->data[pos] = (uint8_t)value;
+	msg->data[pos + 1] = (uint8_t)(value >> 8);
+}
+
+static uint64_t get_uint(struct reader *r, size_t size)
+{
+	uint64_t value = 0;
+
+	if (r->error || r->pos + size > r->size) {
+		r->error = true;
+		return 0;
+	}
+
+	for (size_t i = 0; i < size; i++)
+		value |= (uint64_t)r->data[r->pos + i] << (i * 8);
+	r->pos += size;
+	return value;
+}
+
+static inline uint8_t get_u8(struct reader *r)
+{
+	return (uint8_t)get_uint(r, 1);
+}
+
+static inline uint16_t get_u16(struct reader *r)
+{
+	return (uint16_t)get_uint(r, 2);
+}
+
+static inline uint32_t get_u32(struct reader *r)
+{
+	return (uint32_t)get_uint(r, 4);
+}
+
+static float get_f32(struct reader *r)
+{
+	uint32_t bits = get_u32(r);
+	float value;
+
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+/* returns a copy the caller frees, or NULL on a short message */
+static char *get_str(struct reader *r)
+{
+	size_t len = get_u16(r);
+	char *str;
+
+	if (r->error || r->pos + len > r->size) {
+		r->error = true;
+		return NULL;
+	}
+
+	str = bmalloc(len + 1);
+	memcpy(str, r->data + r->pos, len);
+	str[len] = 0;
+	r->pos += len;
+	return str;
+}
+
+/* ------------------------------------------------------------------------- */
+/* commands */
+
+struct list_data {
+	struct message      *msg;
+	uint16_t            count;
+};
+
+static void list_filter(void *param, obs_source_t *parent,
+	obs_source_t *filter)
+{
+	struct list_data *list = param;
+
+	if (list->count == 0xFFFF)
+		return;
+
+	put_u8(list->msg, CONTROL_KIND_FILTER);
+	put_str(list->msg, obs_source_get_name(parent));
+	put_str(list->msg, obs_source_get_name(filter));
+	list->count++;
+}
+
+static void list_transition(void *param, obs_source_t *source)
+{
+	struct list_data *list = param;
+
+	if (list->count == 0xFFFF ||
+			obs_source_get_type(source) != OBS_SOURCE_TYPE_TRANSITION)
+		return;
+
+	put_u8(list->msg, CONTROL_KIND_TRANSITION);
+	put_str(list->msg, "");
+	put_str(list->msg, obs_source_get_name(source));
+	list->count++;
+}
+
+static bool handle_list(struct reader *r, struct message *reply)
+{
+	struct list_data list = {reply, 0};
+	size_t count_pos = reply->size;
+
+	put_u16(reply, 0);
+	motion_trigger_enum(list_filter, &list);
+	motion_runtime_enum_sources(list_transition, &list);
+	set_u16(reply, count_pos, list.count);
+
+	UNUSED_PARAMETER(r);
+	return true;
+}
+
+static void get_entry(struct reader *r, struct motion_trigger_entry *entry)
+{
+	entry->source = get_str(r);
+	entry->filter = get_str(r);
+	entry->forward = get_u8(r) != 0;
+	entry->offset = get_f32(r);
+}
+
+static void free_entry(struct motion_trigger_entry *entry)
+{
+	bfree((char *)entry->source);
+	bfree((char *)entry->filter);
+}
+
+static bool handle_trigger(struct reader *r, struct message *reply)
+{
+	struct motion_trigger_entry entry;
+	bool queued;
+
+	get_entry(r, &entry);
+	queued = !r->error && motion_trigger_submit(&entry, 1);
+	free_entry(&entry);
+
+	UNUSED_PARAMETER(reply);
+	return queued;
+}
+
+static bool handle_batch(struct reader *r, struct message *reply)
+{
+	size_t count = get_u16(r);
+	struct motion_trigger_entry *entries = bzalloc(
+		sizeof(struct motion_trigger_entry) * (count ? count : 1));
+	bool queued;
+
+	for (size_t i = 0; i < count && !r->error; i++)
+		get_entry(r, &entries[i]);
+
+	queued = !r->error && motion_trigger_submit(entries, count);
+
+	for (size_t i = 0; i < count; i++)
+		free_entry(&entries[i]);
+	bfree(entries);
+
+	UNUSED_PARAMETER(reply);
+	return queued;
+}
+
+struct transition_query {
+	const char          *name;
+	struct motion_trigger_state *state;
+	bool                found;
+};
+
+/* libobs reports 1 for a transition that is not running */
+static void query_transition(void *param, obs_source_t *source)
+{
+	struct transition_query *query = param;
+	float t;
+
+	if (query->found ||
+			obs_source_get_type(source) != OBS_SOURCE_TYPE_TRANSITION ||
+			strcmp(obs_source_get_name(source), query->name) != 0)
+		return;
+
+	t = obs_transition_get_time(source);
+	query->state->running = t > 0.0f && t < 1.0f;
+	query->state->at_end = t >= 1.0f;
+	query->state->progress = t;
+	query->found = true;
+}
+
+static bool handle_query(struct reader *r, struct message *reply)
+{
+	char *source = get_str(r);
+	char *filter = get_str(r);
+	struct motion_trigger_state state = {0};
+	bool found = false;
+
+	if (r->error) {
+		found = false;
+	} else if (*filter) {
+		found = motion_trigger_query(source, filter, &state);
+	} else {
+		struct transition_query query = {source, &state, false};
+		motion_runtime_enum_sources(query_transition, &query);
+		found = query.found;
+	}
+
+	if (found) {
+		put_u8(reply, state.running);
+		put_u8(reply, state.at_end);
+		put_f32(reply, state.progress);
+	}
+
+	bfree(source);
+	bfree(filter);
+	return found;
+}
+
+static bool handle_latency(struct reader *r, struct message *reply)
+{
+	struct motion_stat_summary summary;
+
+	motion_trigger_get_latency(&summary);
+	put_u64(reply, summary.count);
+	put_u64(reply, summary.min);
+	put_u64(reply, summary.mean);
+	put_u64(reply, summary.p99);
+	put_u64(reply, summary.max);
+
+	UNUSED_PARAMETER(r);
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* server */
+
+static bool send_all(int fd, const uint8_t *data, size_t size)
+{
+	while (size) {
+		ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent <= 0)
+			return false;
+
+		data += sent;
+		size -= (size_t)sent;
+	}
+
+	return true;
+}
+
+/* 'data' starts at the op; the reply is one message with the same tag */
+static bool handle_message(int fd, const uint8_t *data, size_t size)
+{
+	struct reader r = {data, size, 0, false};
+	struct message reply = {0};
+	uint8_t op = get_u8(&r);
+	uint32_t tag = get_u32(&r);
+	bool ok, sent;
+
+	put_u32(&reply, 0);
+	put_u8(&reply, CONTROL_OK);
+	put_u32(&reply, tag);
+
+	switch (op) {
+	case CONTROL_LIST:    ok = handle_list(&r, &reply); break;
+	case CONTROL_TRIGGER: ok = handle_trigger(&r, &reply); break;
+	case CONTROL_BATCH:   ok = handle_batch(&r, &reply); break;
+	case CONTROL_QUERY:   ok = handle_query(&r, &reply); break;
+	case CONTROL_LATENCY: ok = handle_latency(&r, &reply); break;
+	default:              ok = false; break;
+	}
+
+	if (!ok || r.error) {
+		reply.size = HEADER_SIZE;
+		reply.data[4] = CONTROL_ERROR;
+	}
+
+	for (size_t i = 0; i < 4; i++)
+		reply.data[i] = (uint8_t)((reply.size - 4) >> (i * 8));
+
+	sent = send_all(fd, reply.data, reply.size);
+	bfree(reply.data);
+	return sent;
+}
+
+static void close_client(struct client *client)
+{
+	close(client->fd);
+	bfree(client->buffer);
+	client->fd = -1;
+	client->buffer = NULL;
+	client->size = 0;
+}
+
+static void accept_client(void)
+{
+	struct timeval timeout = {SEND_TIMEOUT_SEC, 0};
+	int fd = accept(listen_fd, NULL, NULL);
+
+	if (fd < 0)
+		return;
+
+	for (size_t i = 0; i < MAX_CLIENTS; i++) {
+		if (clients[i].fd < 0) {
+			/* a client that stops reading is dropped */
+			setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+				sizeof(timeout));
+			clients[i].fd = fd;
+			clients[i].buffer = bmalloc(4 + CONTROL_MAX_MESSAGE);
+			clients[i].size = 0;
+			return;
+		}
+	}
+
+	blog(LOG_WARNING, "[motion-effect] control socket: too many clients");
+	close(fd);
+}
+
+static void read_client(struct client *client)
+{
+	ssize_t received = recv(client->fd, client->buffer + client->size,
+		4 + CONTROL_MAX_MESSAGE - client->size, 0);
+
+	if (received < 0 && errno == EINTR)
+		return;
+	if (received <= 0) {
+		close_client(client);
+		return;
+	}
+
+	client->size += (size_t)received;
+
+	while (client->size >= 4) {
+		const uint8_t *buf = client->buffer;
+		size_t len = (size_t)buf[0] | (size_t)buf[1] << 8 |
+			(size_t)buf[2] << 16 | (size_t)buf[3] << 24;
+
+		if (len < HEADER_SIZE - 4 || len > CONTROL_MAX_MESSAGE) {
+			close_client(client);
+			return;
+		}
+		if (client->size < 4 + len)
+			break;
+
+		if (!handle_message(client->fd, buf + 4, len)) {
+			close_client(client);
+			return;
+		}
+
+		client->size -= 4 + len;
+		memmove(client->buffer, client->buffer + 4 + len,
+			client->size);
+	}
+}
+
+static void *server_thread_func(void *data)
+{
+	os_set_thread_name("motion-effect: control");
+
+	for (;;) {
+		struct pollfd fds[MAX_CLIENTS + 2];
+		struct client *polled[MAX_CLIENTS];
+		nfds_t count = 2;
+
+		fds[0].fd = wake_pipe[0];
+		fds[0].events = POLLIN;
+		fds[1].fd = listen_fd;
+		fds[1].events = POLLIN;
+
+		for (size_t i = 0; i < MAX_CLIENTS; i++) {
+			if (clients[i].fd < 0)
+				continue;
+			polled[count - 2] = &clients[i];
+			fds[count].fd = clients[i].fd;
+			fds[count].events = POLLIN;
+			count++;
+		}
+
+		if (poll(fds, count, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		if (fds[0].revents)
+			break;
+		if (fds[1].revents & POLLIN)
+			accept_client();
+
+		for (nfds_t i = 2; i < count; i++) {
+			if (fds[i].revents)
+				read_client(polled[i - 2]);
+		}
+	}
+
+	UNUSED_PARAMETER(data);
+	return NULL;
+}
+
+static void close_fds(void)
+{
+	for (size_t i = 0; i < MAX_CLIENTS; i++) {
+		if (clients[i].fd >= 0)
+			close_client(&clients[i]);
+	}
+
+	if (listen_fd >= 0)
+		close(listen_fd);
+	if (wake_pipe[0] >= 0)
+		close(wake_pipe[0]);
+	if (wake_pipe[1] >= 0)
+		close(wake_pipe[1]);
+
+	listen_fd = -1;
+	wake_pipe[0] = wake_pipe[1] = -1;
+}
+
+static void init_failed(const char *path)
+{
+	blog(LOG_WARNING, "[motion-effect] failed to open control "
+		"socket '%s': %s", path, strerror(errno));
+	close_fds();
+}
+
+/* only a socket left over from an earlier run is replaced */
+static bool remove_stale_socket(const char *path)
+{
+	struct stat st;
+
+	if (stat(path, &st) != 0)
+		return true;
+	return S_ISSOCK(st.st_mode) && unlink(path) == 0;
+}
+
+void motion_control_init(void)
+{
+	const char *path = getenv(CONTROL_ENV);
+	struct sockaddr_un addr;
+
+	if (!path || !*path || running)
+		return;
+
+	memset(&addr, 0, sizeof(addr));
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		blog(LOG_WARNING, "[motion-effect] control socket path '%s' "
+			"is too long", path);
+		return;
+	}
+
+	for (size_t i = 0; i < MAX_CLIENTS; i++)
+		clients[i].fd = -1;
+
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	if (!remove_stale_socket(path) ||
+			(listen_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+			bind(listen_fd, (struct sockaddr *)&addr,
+				sizeof(addr)) != 0) {
+		init_failed(path);
+		return;
+	}
+
+	/* once bound, the socket file is ours to remove on failure */
+	if (listen(listen_fd, MAX_CLIENTS) != 0 ||
+			pipe(wake_pipe) != 0 ||
+			pthread_create(&server_thread, NULL, server_thread_func,
+				NULL) != 0) {
+		init_failed(path);
+		unlink(path);
+		return;
+	}
+
+	socket_path = bstrdup(path);
+	running = true;
+	blog(LOG_INFO, "[motion-effect] control socket listening on '%s'",
+		path);
+}
+
+void motion_control_free(void)
+{
+	if (!running)
+		return;
+
+	/* if the wake byte can't be written, closing the write end hangs up
+	 * the read end, which wakes the thread just the same */
+	if (write(wake_pipe[1], "", 1) != 1) {
+		close(wake_pipe[1]);
+		wake_pipe[1] = -1;
+	}
+	pthread_join(server_thread, NULL);
+
+	close_fds();
+	unlink(socket_path);
+	bfree(socket_path);
+	socket_path = NULL;
+	running = false;
+}
+
+#endif
@@ -0,0 +1,74 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#pragma once
+
+#include <obs-module.h>
+
+/*
+ * Opt-in local control socket for show controllers and scripts. Set
+ * MOTION_EFFECT_CONTROL to a socket path before starting OBS and a server
+ * thread listens on that Unix domain socket (not available on Windows).
+ * Triggers are fed to the same lock-free queue as the trigger procs, so
+ * they start on the next frame without the hotkey system.
+ *
+ * Every message, both ways, all values little-endian:
+ *
+ *   u32 size of what follows, u8 op or status, u32 tag, payload
+ *
+ * The tag is echoed in the reply, so requests can be pipelined. A reply
+ * starts with CONTROL_OK or CONTROL_ERROR; an error has no payload.
+ *
+ *   CONTROL_LIST     -> u16 count, count x (u8 kind, str parent, str name)
+ *   CONTROL_TRIGGER  str source, str filter, u8 forward, f32 offset
+ *   CONTROL_BATCH    u16 count, count x (str source, str filter,
+ *                    u8 forward, f32 offset)
+ *   CONTROL_QUERY    str source, str filter
+ *                    -> u8 running, u8 at end, f32 progress
+ *   CONTROL_LATENCY  -> u64 count, u64 min, u64 mean, u64 p99, u64 max
+ *
+ * where str is a u16 length followed by that many bytes. Transitions are
+ * listed with an empty parent and queried with an empty filter and their
+ * name as source. Latency is measured from a batch being queued, by any
+ * front end, to the frame it is started on, in nanoseconds.
+ */
+
+#define CONTROL_MAX_MESSAGE 65536
+
+enum control_op {
+	CONTROL_LIST = 1,
+	CONTROL_TRIGGER = 2,
+	CONTROL_BATCH = 3,
+	CONTROL_QUERY = 4,
+	CONTROL_LATENCY = 5
+};
+
+enum control_status {
+	CONTROL_OK = 0,
+	CONTROL_ERROR = 1
+};
+
+enum control_kind {
+	CONTROL_KIND_FILTER = 0,
+	CONTROL_KIND_TRANSITION = 1
+};
+
+void motion_control_init(void);
+void motion_control_free(void);
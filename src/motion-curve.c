@@ -0,0 +1,156 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#include "motion-curve.h"
+#include <util/threading.h>
+
+#define CURVE_BUCKETS 64
+
+static pthread_mutex_t curves_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct motion_curve *buckets[CURVE_BUCKETS];
+static size_t num_curves;
+
+/* FNV-1a over the parameters, which are zeroed padding included */
+static uint32_t hash_params(const struct motion_curve_params *params)
+{
+	const uint8_t *data = (const uint8_t*)params;
+	uint32_t hash = 2166136261u;
+
+	for (size_t i = 0; i < sizeof(*params); i++) {
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static void compile_curve(struct motion_curve *curve)
+{
+	const struct motion_curve_params *params = &curve->params;
+
+	if (params->spring) {
+		spring_init(&curve->spring, params->spring_frequency,
+			params->spring_damping);
+		curve->settle = params->spring_settle / 100.0f;
+	} else if (params->acceleration != 0.0f) {
+		curve->eased = true;
+		curve->ease[0] = 0.0f;
+		curve->ease[1] = (-(params->acceleration) + 1.0f) / 2;
+		curve->ease[2] = 1.0f;
+	}
+}
+
+const struct motion_curve *motion_curve_get(
+	const struct motion_curve_params *params)
+{
+	struct motion_curve_params key;
+	struct motion_curve *curve;
+	uint32_t hash;
+
+	memset(&key, 0, sizeof(key));
+	key.order = params->order;
+	key.spring = params->spring;
+	key.acceleration = params->acceleration;
+	key.spring_frequency = params->spring_frequency;
+	key.spring_damping = params->spring_damping;
+	key.spring_settle = params->spring_settle;
+	hash = hash_params(&key);
+
+	pthread_mutex_lock(&curves_mutex);
+
+	for (curve = buckets[hash % CURVE_BUCKETS]; curve; curve = curve->next) {
+		if (curve->hash == hash &&
+		    memcmp(&curve->params, &key, sizeof(key)) == 0) {
+			os_atomic_inc_long(&curve->refs);
+			pthread_mutex_unlock(&curves_mutex);
+			return curve;
+		}
+	}
+
+	curve = bzalloc(sizeof(*curve));
+	curve->refs = 1;
+	curve->hash = hash;
+	curve->params = key;
+	compile_curve(curve);
+
+	curve->next = buckets[hash % CURVE_BUCKETS];
+	buckets[hash % CURVE_BUCKETS] = curve;
+	num_curves++;
+
+	pthread_mutex_unlock(&curves_mutex);
+	return curve;
+}
+
+const struct motion_curve *motion_curve_addref(
+	const struct motion_curve *curve)
+{
+	if (curve)
+		os_atomic_inc_long(&((struct motion_curve*)curve)->refs);
+	return curve;
+}
+
+void motion_curve_release(const struct motion_curve *curve)
+{
+	struct motion_curve *entry = (struct motion_curve*)curve;
+	struct motion_curve **prev;
+	long refs;
+
+	if (!entry)
+		return;
+
+	/* releases that leave other references drop theirs without the lock */
+	refs = os_atomic_load_long(&entry->refs);
+	while (refs > 1) {
+		if (os_atomic_compare_swap_long(&entry->refs, refs, refs - 1))
+			return;
+		refs = os_atomic_load_long(&entry->refs);
+	}
+
+	/* the count only reaches zero under the lock, so a lookup can't
+	 * revive a curve that is being freed */
+	pthread_mutex_lock(&curves_mutex);
+
+	if (os_atomic_dec_long(&entry->refs) > 0) {
+		pthread_mutex_unlock(&curves_mutex);
+		return;
+	}
+
+	prev = &buckets[entry->hash % CURVE_BUCKETS];
+	for (; *prev; prev = &(*prev)->next) {
+		if (*prev == entry) {
+			*prev = entry->next;
+			break;
+		}
+	}
+	num_curves--;
+
+	pthread_mutex_unlock(&curves_mutex);
+	bfree(entry);
+}
+
+size_t motion_curve_count(void)
+{
+	size_t count;
+
+	pthread_mutex_lock(&curves_mutex);
+	count = num_curves;
+	pthread_mutex_unlock(&curves_mutex);
+	return count;
+}
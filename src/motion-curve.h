@@ -0,0 +1,69 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#pragma once
+
+#include <obs-module.h>
+#include "helper.h"
+
+/*
+ * Compiled motion curves, interned module-wide. A curve holds everything
+ * about a motion that does not depend on where the item is when it
+ * starts: the path order, the easing of time and the spring constants.
+ * Filters with identical parameters get the same reference-counted,
+ * immutable object, so a curve is compiled once however many filters use
+ * it. Lookups and a release that may drop the last reference take a
+ * lock; other releases and evaluating a curve do not.
+ */
+
+/* fields a curve does not use must be zero, so equal curves compare equal */
+struct motion_curve_params {
+	int                 order;
+	bool                spring;
+	float               acceleration;
+	float               spring_frequency;
+	float               spring_damping;
+	float               spring_settle;
+};
+
+struct motion_curve {
+	struct motion_curve *next;
+	volatile long       refs;
+	uint32_t            hash;
+	struct motion_curve_params params;
+	bool                eased;
+	float               ease[3];
+	struct spring       spring;
+	float               settle;
+};
+
+const struct motion_curve *motion_curve_get(
+	const struct motion_curve_params *params);
+const struct motion_curve *motion_curve_addref(
+	const struct motion_curve *curve);
+void motion_curve_release(const struct motion_curve *curve);
+
+size_t motion_curve_count(void);
+
+static inline float motion_curve_ease(const struct motion_curve *curve,
+	float t)
+{
+	return curve->eased ? bezier((float*)curve->ease, t, 2) : t;
+}
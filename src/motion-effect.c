@@ -0,0 +1,45 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#include <obs-module.h>
+#include "motion-runtime.h"
+
+/*
+ * The one plugin module: both source types are registered on top of the
+ * runtime in motion-runtime.c, so they share its services.
+ */
+
+OBS_DECLARE_MODULE()
+OBS_MODULE_USE_DEFAULT_LOCALE("motion-effect", "en-US")
+
+extern struct obs_source_info motion_filter;
+extern struct obs_source_info motion_transition;
+
+bool obs_module_load(void) {
+	motion_runtime_init();
+	obs_register_source(&motion_filter);
+	obs_register_source(&motion_transition);
+	return true;
+}
+
+void obs_module_unload(void)
+{
+	motion_runtime_free();
+}
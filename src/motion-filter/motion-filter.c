@@ -23,31 +23,74 @@
 #include <obs-scene.h>
 #include <obs-frontend-api.h>
 #include <util/dstr.h>
+#include <util/platform.h>
+#include <util/threading.h>
 #include "../helper.h"
+#include "../motion-runtime.h"
+#include "../motion-curve.h"
+#include "../motion-trace.h"
+#include "../motion-record.h"
+#include "../motion-trigger.h"
 
 // Define property keys
 
 enum {
 	PATH_LINEAR = 0,
 	PATH_QUADRATIC = 1,
-	PATH_CUBIC = 2
+	PATH_CUBIC = 2,
+	PATH_SPRING = 3
 };
 
 enum {
 	BEHAVIOR_NONE = 0,
 	BEHAVIOR_ONE_WAY = 1,
 	BEHAVIOR_ROUND_TRIP = 2,
-	BEHAVIOR_SCENE_SWITCH =3
+	BEHAVIOR_SCENE_SWITCH =3,
+	BEHAVIOR_LOOP = 4,
+	BEHAVIOR_PING_PONG = 5
 };
 
 #define VARIATION_POSITION  (1<<0)
 #define VARIATION_SIZE      (1<<1)
+#define VARIATION_ROTATION  (1<<2)
+#define VARIATION_BOUNDS    (1<<3)
+#define VARIATION_CROP      (1<<4)
+#define VARIATION_ALWAYS    (VARIATION_POSITION | VARIATION_SIZE)
+
+/*
+ * Every animated value of the item, each one a bezier over its own
+ * control points. Position runs along the selected path, the other
+ * channels are linear. Channels the filter does not change keep their
+ * start value; position and scale are still written every frame as they
+ * always were, the other channels only when selected.
+ */
+enum {
+	CHANNEL_POS_X = 0,
+	CHANNEL_POS_Y,
+	CHANNEL_SCALE_X,
+	CHANNEL_SCALE_Y,
+	CHANNEL_ROT,
+	CHANNEL_BOUNDS_X,
+	CHANNEL_BOUNDS_Y,
+	CHANNEL_CROP_LEFT,
+	CHANNEL_CROP_TOP,
+	CHANNEL_CROP_RIGHT,
+	CHANNEL_CROP_BOTTOM,
+	CHANNEL_COUNT
+};
 
 #define S_MOTION_END        "motion_end"
 #define S_ORG_X             "org_x"
 #define S_ORG_Y             "org_y"
 #define S_ORG_W             "org_w"
 #define S_ORG_H             "org_h"
+#define S_ORG_ROT           "org_rot"
+#define S_ORG_BOUNDS_W      "org_bounds_w"
+#define S_ORG_BOUNDS_H      "org_bounds_h"
+#define S_ORG_CROP_LEFT     "org_crop_left"
+#define S_ORG_CROP_TOP      "org_crop_top"
+#define S_ORG_CROP_RIGHT    "org_crop_right"
+#define S_ORG_CROP_BOTTOM   "org_crop_bottom"
 #define S_START_X           "start_x"
 #define S_START_Y           "start_y"
 #define S_START_W           "start_w"
@@ -63,8 +106,21 @@ enum {
 #define S_DST_W             "dst_w"
 #define S_DST_H             "dst_h"
 #define S_USE_DST_SCALE     "dst_use_scale"
+#define S_CHANGE_ROT        "change_rot"
+#define S_DST_ROT           "dst_rot"
+#define S_CHANGE_BOUNDS     "change_bounds"
+#define S_DST_BOUNDS_W      "dst_bounds_w"
+#define S_DST_BOUNDS_H      "dst_bounds_h"
+#define S_CHANGE_CROP       "change_crop"
+#define S_DST_CROP_LEFT     "dst_crop_left"
+#define S_DST_CROP_TOP      "dst_crop_top"
+#define S_DST_CROP_RIGHT    "dst_crop_right"
+#define S_DST_CROP_BOTTOM   "dst_crop_bottom"
 #define S_DURATION          "duration"
 #define S_ACCELERATION      "acceleration"
+#define S_SPRING_FREQUENCY  "spring_frequency"
+#define S_SPRING_DAMPING    "spring_damping"
+#define S_SPRING_SETTLE     "spring_settle"
 #define S_SOURCE            "source_id"
 #define S_FORWARD           "forward"
 #define S_BACKWARD          "backward"
@@ -72,6 +128,7 @@ enum {
 #define S_MOTION_BEHAVIOR   "motion_behavior"
 #define S_VARIATION_TYPE    "variation_type"
 #define S_SCENE_NAME        "scene_name"
+#define S_RECORD            "record"
 
 // Define property localisation tags
 #define T_(v)               obs_module_text(v)
@@ -79,6 +136,10 @@ enum {
 #define T_PATH_LINEAR       T_("PathType.Linear")
 #define T_PATH_QUADRATIC    T_("PathType.Quadratic")
 #define T_PATH_CUBIC        T_("PathType.Cubic")
+#define T_PATH_SPRING       T_("PathType.Spring")
+#define T_SPRING_FREQUENCY  T_("Spring.Frequency")
+#define T_SPRING_DAMPING    T_("Spring.Damping")
+#define T_SPRING_SETTLE     T_("Spring.Settle")
 #define T_START_SETTING     T_("Start.Setting")
 #define T_START_X           T_("Start.X")
 #define T_START_Y           T_("Start.Y")
@@ -92,6 +153,16 @@ enum {
 #define T_DST_Y             T_("Destination.Y")
 #define T_DST_W             T_("Destination.W")
 #define T_DST_H             T_("Destination.H")
+#define T_CHANGE_ROT        T_("ChangeRotation")
+#define T_DST_ROT           T_("Destination.Rotation")
+#define T_CHANGE_BOUNDS     T_("ChangeBounds")
+#define T_DST_BOUNDS_W      T_("Destination.BoundsW")
+#define T_DST_BOUNDS_H      T_("Destination.BoundsH")
+#define T_CHANGE_CROP       T_("ChangeCrop")
+#define T_DST_CROP_LEFT     T_("Destination.CropLeft")
+#define T_DST_CROP_TOP      T_("Destination.CropTop")
+#define T_DST_CROP_RIGHT    T_("Destination.CropRight")
+#define T_DST_CROP_BOTTOM   T_("Destination.CropBottom")
 #define T_DURATION          T_("Duration")
 #define T_ACCELERATION      T_("Acceleration")
 #define T_SOURCE            T_("SourceName")
@@ -107,20 +178,25 @@ enum {
 #define T_HOTKEY_ONE_WAY    T_("Behavior.OneWay")
 #define T_HOTKEY_ROUND_TRIP T_("Behavior.RoundTrip")
 #define T_SCENE_SWITCH      T_("Behavior.SceneSwitch")
+#define T_LOOP              T_("Behavior.Loop")
+#define T_PING_PONG         T_("Behavior.PingPong")
+#define T_RECORD            T_("Record")
 
 typedef struct variation_data variation_data_t;
 typedef struct motion_filter_data motion_filter_data_t;
 
 struct variation_data {
-	float               point_x[4];
-	float               point_y[4];
-	float               scale_x[2];
-	float               scale_y[2];
-	float               coeff[3];
+	float               points[CHANNEL_COUNT][4];
+	int                 order[CHANNEL_COUNT];
+	float               value[CHANNEL_COUNT];
 	struct vec2         scale;
 	struct vec2         position;	
 	float               elapsed_time;
-	bool                coeff_varaite;
+	float               duration;
+	const struct motion_curve *curve;
+	float               spring_a[CHANNEL_COUNT];
+	float               spring_b[CHANNEL_COUNT];
+	float               target[CHANNEL_COUNT];
 };
 
 struct motion_filter_data {
@@ -136,8 +212,7 @@ struct motion_filter_data {
 	bool                motion_end;
 	bool                use_start_position;
 	bool                use_start_scale;
-	bool                change_position;
-	bool                change_size;
+	uint32_t            channels;
 	int                 motion_behavior;
 	int                 path_type;
 	int                 org_width;
@@ -148,10 +223,86 @@ struct motion_filter_data {
 	struct vec2         ctrl_pos;
 	struct vec2         ctrl2_pos;
 	struct vec2         dst_pos;
+	float               dst_rot;
+	struct vec2         dst_bounds;
+	struct obs_sceneitem_crop dst_crop;
 	float               duration;
 	float               acceleration;
+	float               spring_frequency;
+	float               spring_damping;
+	float               spring_settle;
+	const struct motion_curve *curve;
 	char                *item_name;
 	int64_t             item_id;
+	struct motion_stats stats;
+	uint32_t            record_id;
+	bool                record;
+	volatile bool       stop_pending;
+	bool                staged;
+	uint64_t            staged_ns;
+	double              phase;
+};
+
+/* everything update and create read, so a replay sees the same filter */
+static const struct motion_record_key record_keys[] = {
+	{S_MOTION_BEHAVIOR, RECORD_INT},
+	{S_PATH_TYPE,       RECORD_INT},
+	{S_START_X,         RECORD_INT},
+	{S_START_Y,         RECORD_INT},
+	{S_START_W,         RECORD_INT},
+	{S_START_H,         RECORD_INT},
+	{S_CTRL_X,          RECORD_INT},
+	{S_CTRL_Y,          RECORD_INT},
+	{S_CTRL2_X,         RECORD_INT},
+	{S_CTRL2_Y,         RECORD_INT},
+	{S_DST_X,           RECORD_INT},
+	{S_DST_Y,           RECORD_INT},
+	{S_DST_W,           RECORD_INT},
+	{S_DST_H,           RECORD_INT},
+	{S_CHANGE_ROT,      RECORD_BOOL},
+	{S_DST_ROT,         RECORD_DOUBLE},
+	{S_CHANGE_BOUNDS,   RECORD_BOOL},
+	{S_DST_BOUNDS_W,    RECORD_INT},
+	{S_DST_BOUNDS_H,    RECORD_INT},
+	{S_CHANGE_CROP,     RECORD_BOOL},
+	{S_DST_CROP_LEFT,   RECORD_INT},
+	{S_DST_CROP_TOP,    RECORD_INT},
+	{S_DST_CROP_RIGHT,  RECORD_INT},
+	{S_DST_CROP_BOTTOM, RECORD_INT},
+	{S_DURATION,        RECORD_DOUBLE},
+	{S_ACCELERATION,    RECORD_DOUBLE},
+	{S_SPRING_FREQUENCY, RECORD_DOUBLE},
+	{S_SPRING_DAMPING,  RECORD_DOUBLE},
+	{S_SPRING_SETTLE,   RECORD_DOUBLE},
+	{S_START_SETTING,   RECORD_BOOL},
+	{S_VARIATION_TYPE,  RECORD_INT},
+	{S_SOURCE,          RECORD_STRING},
+	{S_SCENE_NAME,      RECORD_STRING},
+	{S_MOTION_END,      RECORD_BOOL},
+	{S_ORG_X,           RECORD_DOUBLE},
+	{S_ORG_Y,           RECORD_DOUBLE},
+	{S_ORG_W,           RECORD_DOUBLE},
+	{S_ORG_H,           RECORD_DOUBLE},
+	{S_ORG_ROT,         RECORD_DOUBLE},
+	{S_ORG_BOUNDS_W,    RECORD_DOUBLE},
+	{S_ORG_BOUNDS_H,    RECORD_DOUBLE},
+	{S_ORG_CROP_LEFT,   RECORD_DOUBLE},
+	{S_ORG_CROP_TOP,    RECORD_DOUBLE},
+	{S_ORG_CROP_RIGHT,  RECORD_DOUBLE},
+	{S_ORG_CROP_BOTTOM, RECORD_DOUBLE},
+};
+
+/* where each channel's start value is kept for the way back */
+static const char *org_keys[CHANNEL_COUNT] = {
+	S_ORG_X, S_ORG_Y, S_ORG_W, S_ORG_H, S_ORG_ROT, S_ORG_BOUNDS_W,
+	S_ORG_BOUNDS_H, S_ORG_CROP_LEFT, S_ORG_CROP_TOP, S_ORG_CROP_RIGHT,
+	S_ORG_CROP_BOTTOM
+};
+
+static const uint32_t channel_variation[CHANNEL_COUNT] = {
+	VARIATION_POSITION, VARIATION_POSITION, VARIATION_SIZE, VARIATION_SIZE,
+	VARIATION_ROTATION, VARIATION_BOUNDS, VARIATION_BOUNDS, VARIATION_CROP,
+	VARIATION_CROP, VARIATION_CROP, VARIATION_CROP
 };
 
 static inline bool is_reverse(motion_filter_data_t *filter)
@@ -160,71 +311,299 @@ static inline bool is_reverse(motion_filter_data_t *filter)
 		filter->motion_behavior == BEHAVIOR_ROUND_TRIP;
 }
 
+/* loop and ping-pong run until triggered backward */
+static inline bool is_cyclic(motion_filter_data_t *filter)
+{
+	return filter->motion_behavior == BEHAVIOR_LOOP ||
+		filter->motion_behavior == BEHAVIOR_PING_PONG;
+}
+
+static inline bool has_backward(motion_filter_data_t *filter)
+{
+	return filter->motion_behavior == BEHAVIOR_ROUND_TRIP ||
+		is_cyclic(filter);
+}
+
+static inline double cycle_period(motion_filter_data_t *filter)
+{
+	double duration = filter->variation.duration;
+	return filter->motion_behavior == BEHAVIOR_PING_PONG ?
+		2.0 * duration : duration;
+}
+
 static inline const char* get_scene_name(motion_filter_data_t *filter)
 {
 	obs_source_t* scene = obs_filter_get_parent(filter->context);
 	return obs_source_get_name(scene);
 }
 
+static inline int path_order(motion_filter_data_t *filter)
+{
+	if (filter->path_type == PATH_QUADRATIC)
+		return 2;
+	else if (filter->path_type == PATH_CUBIC)
+		return 3;
+	else
+		return 1;
+}
+
+static inline bool use_spring(variation_data_t *var)
+{
+	return var->curve && var->curve->params.spring;
+}
+
+static void get_curve_params(motion_filter_data_t *filter,
+	struct motion_curve_params *params)
+{
+	memset(params, 0, sizeof(*params));
+	params->order = path_order(filter);
+
+	if (filter->path_type == PATH_SPRING) {
+		params->spring = true;
+		params->spring_frequency = filter->spring_frequency;
+		params->spring_damping = filter->spring_damping;
+		params->spring_settle = filter->spring_settle;
+	} else {
+		params->acceleration = filter->acceleration;
+	}
+}
+
+/*
+ * Sets the spring off from the given values and velocities toward the
+ * end of the current direction. The motion lasts until every channel
+ * settles within spring_settle percent of how far it had to go.
+ */
+static void start_spring(motion_filter_data_t *filter, const float *value,
+	const float *velocity)
+{
+	variation_data_t *var = &filter->variation;
+	const struct spring *spring = &var->curve->spring;
+	bool reverse = is_reverse(filter);
+
+	var->duration = 0.0f;
+	var->elapsed_time = 0.0f;
+
+	for (int i = 0; i < CHANNEL_COUNT; i++) {
+		float target = reverse ? var->points[i][0] :
+			var->points[i][var->order[i]];
+		float x0 = value[i] - target;
+		float v0 = velocity ? velocity[i] : 0.0f;
+		float ref = fmaxf(fabsf(x0), fabsf(v0) / spring->omega);
+		float t;
+
+		var->target[i] = target;
+		spring_coefficients(spring, x0, v0, &var->spring_a[i],
+			&var->spring_b[i]);
+
+		if (ref <= 0.0f)
+			continue;
+
+		t = spring_settle_time(spring, var->spring_a[i],
+			var->spring_b[i], var->curve->settle * ref);
+		if (t > var->duration)
+			var->duration = t;
+	}
+}
+
+static void eval_spring(variation_data_t *var, float *value, float *velocity)
+{
+	struct spring_frame frame;
+
+	if (var->elapsed_time >= var->duration) {
+		for (int i = 0; i < CHANNEL_COUNT; i++) {
+			value[i] = var->target[i];
+			if (velocity)
+				velocity[i] = 0.0f;
+		}
+		return;
+	}
+
+	spring_eval_frame(&var->curve->spring, var->elapsed_time, &frame);
+
+	for (int i = 0; i < CHANNEL_COUNT; i++) {
+		float a = var->spring_a[i];
+		float b = var->spring_b[i];
+
+		value[i] = var->target[i] + frame.decay * (a * frame.c +
+			b * frame.s);
+		if (velocity)
+			velocity[i] = frame.decay * (a * frame.dc + b * frame.ds);
+	}
+}
+
+static void get_item_channels(obs_sceneitem_t *item, float *values)
+{
+	struct obs_transform_info info;
+	struct obs_sceneitem_crop crop;
+
+	obs_sceneitem_get_info(item, &info);
+	obs_sceneitem_get_crop(item, &crop);
+
+	values[CHANNEL_POS_X] = info.pos.x;
+	values[CHANNEL_POS_Y] = info.pos.y;
+	values[CHANNEL_SCALE_X] = info.scale.x;
+	values[CHANNEL_SCALE_Y] = info.scale.y;
+	values[CHANNEL_ROT] = info.rot;
+	values[CHANNEL_BOUNDS_X] = info.bounds.x;
+	values[CHANNEL_BOUNDS_Y] = info.bounds.y;
+	values[CHANNEL_CROP_LEFT] = (float)crop.left;
+	values[CHANNEL_CROP_TOP] = (float)crop.top;
+	values[CHANNEL_CROP_RIGHT] = (float)crop.right;
+	values[CHANNEL_CROP_BOTTOM] = (float)crop.bottom;
+}
+
+/*
+ * Writes the channels selected by the variation mask in one go and
+ * returns the number of setter calls made.
+ */
+static int set_item_channels(obs_sceneitem_t *item, const float *values,
+	uint32_t channels)
+{
+	int setters = 0;
+
+	if (channels & VARIATION_POSITION) {
+		struct vec2 pos;
+		vec2_set(&pos, values[CHANNEL_POS_X], values[CHANNEL_POS_Y]);
+		obs_sceneitem_set_pos(item, &pos);
+		setters++;
+	}
+
+	if (channels & VARIATION_SIZE) {
+		struct vec2 scale;
+		vec2_set(&scale, values[CHANNEL_SCALE_X],
+			values[CHANNEL_SCALE_Y]);
+		obs_sceneitem_set_scale(item, &scale);
+		setters++;
+	}
+
+	if (channels & VARIATION_ROTATION) {
+		obs_sceneitem_set_rot(item, values[CHANNEL_ROT]);
+		setters++;
+	}
+
+	if (channels & VARIATION_BOUNDS) {
+		struct vec2 bounds;
+		vec2_set(&bounds, values[CHANNEL_BOUNDS_X],
+			values[CHANNEL_BOUNDS_Y]);
+		obs_sceneitem_set_bounds(item, &bounds);
+		setters++;
+	}
+
+	if (channels & VARIATION_CROP) {
+		struct obs_sceneitem_crop crop;
+		crop.left = (int)roundf(values[CHANNEL_CROP_LEFT]);
+		crop.top = (int)roundf(values[CHANNEL_CROP_TOP]);
+		crop.right = (int)roundf(values[CHANNEL_CROP_RIGHT]);
+		crop.bottom = (int)roundf(values[CHANNEL_CROP_BOTTOM]);
+		obs_sceneitem_set_crop(item, &crop);
+		setters++;
+	}
+
+	return setters;
+}
+
 static void update_variation_data(motion_filter_data_t *filter)
 {
 	variation_data_t *var = &filter->variation;
+	struct motion_curve_params params;
+	int order;
+
+	/* the filter holds this curve since its last update, so it is a hit */
+	get_curve_params(filter, &params);
+	motion_curve_release(var->curve);
+	var->curve = motion_curve_get(&params);
+	order = var->curve->params.order;
+
+	var->duration = filter->duration;
 
 	if (!check_item_basesize(filter->item))
 		return ;
 
 	if (!is_reverse(filter)) {
-		struct obs_transform_info info;
-		obs_sceneitem_get_info(filter->item, &info);
-		if (!filter->use_start_position) {
-			var->point_x[0] = info.pos.x;
-			var->point_y[0] = info.pos.y;
-		}
-		if (!filter->use_start_scale) {
-			var->scale_x[0] = info.scale.x;
-			var->scale_y[0] = info.scale.y;
-		}
-
+		float current[CHANNEL_COUNT];
+		get_item_channels(filter->item, current);
+		for (int i = 0; i < CHANNEL_COUNT; i++)
+			var->points[i][0] = current[i];
 	}
 
 	if (filter->use_start_position){
-		var->point_x[0] = filter->org_pos.x;
-		var->point_y[0] = filter->org_pos.y;
+		var->points[CHANNEL_POS_X][0] = filter->org_pos.x;
+		var->points[CHANNEL_POS_Y][0] = filter->org_pos.y;
 	}
 
-	if (filter->path_type >= PATH_QUADRATIC) {
-		var->point_x[1] = filter->ctrl_pos.x;
-		var->point_y[1] = filter->ctrl_pos.y;
+	if (order >= 2) {
+		var->points[CHANNEL_POS_X][1] = filter->ctrl_pos.x;
+		var->points[CHANNEL_POS_Y][1] = filter->ctrl_pos.y;
 	}
 		
-	if (filter->path_type == PATH_CUBIC) {
-		var->point_x[2] = filter->ctrl2_pos.x;
-		var->point_y[2] = filter->ctrl2_pos.y;
+	if (order == 3) {
+		var->points[CHANNEL_POS_X][2] = filter->ctrl2_pos.x;
+		var->points[CHANNEL_POS_Y][2] = filter->ctrl2_pos.y;
 	}
 		
-	var->point_x[filter->path_type + 1] = filter->dst_pos.x;
-	var->point_y[filter->path_type + 1] = filter->dst_pos.y;
+	var->points[CHANNEL_POS_X][order] = filter->dst_pos.x;
+	var->points[CHANNEL_POS_Y][order] = filter->dst_pos.y;
 
 	if(filter->use_start_scale) {
-		cal_scale(filter->item, &var->scale_x[0],
-			&var->scale_y[0], filter->org_width, filter->org_height);
+		cal_scale(filter->item, &var->points[CHANNEL_SCALE_X][0],
+			&var->points[CHANNEL_SCALE_Y][0], filter->org_width,
+			filter->org_height);
 	}
 
-	cal_scale(filter->item, &var->scale_x[1],
-		&var->scale_y[1], filter->dst_width, filter->dst_height);
+	cal_scale(filter->item, &var->points[CHANNEL_SCALE_X][1],
+		&var->points[CHANNEL_SCALE_Y][1], filter->dst_width,
+		filter->dst_height);
 
-	if (filter->acceleration != 0) {
-		var->coeff_varaite = true;
-		var->coeff[0] = 0.0f;
-		var->coeff[1] = (-(filter->acceleration) + 1.0f) / 2;
-		var->coeff[2] = 1.0f;
-	} else
-		var->coeff_varaite = false;
+	var->points[CHANNEL_ROT][1] = filter->dst_rot;
+	var->points[CHANNEL_BOUNDS_X][1] = filter->dst_bounds.x;
+	var->points[CHANNEL_BOUNDS_Y][1] = filter->dst_bounds.y;
+	var->points[CHANNEL_CROP_LEFT][1] = (float)filter->dst_crop.left;
+	var->points[CHANNEL_CROP_TOP][1] = (float)filter->dst_crop.top;
+	var->points[CHANNEL_CROP_RIGHT][1] = (float)filter->dst_crop.right;
+	var->points[CHANNEL_CROP_BOTTOM][1] = (float)filter->dst_crop.bottom;
+
+	for (int i = 0; i < CHANNEL_COUNT; i++)
+		var->order[i] = (filter->channels & channel_variation[i]) ? 1 : 0;
+
+	if (filter->channels & VARIATION_POSITION) {
+		var->order[CHANNEL_POS_X] = order;
+		var->order[CHANNEL_POS_Y] = order;
+	}
 
 	var->elapsed_time = 0.0f;
+
+	if (use_spring(var)) {
+		float start[CHANNEL_COUNT];
+		bool reverse = is_reverse(filter);
+
+		for (int i = 0; i < CHANNEL_COUNT; i++)
+			start[i] = reverse ? var->points[i][var->order[i]] :
+				var->points[i][0];
+		start_spring(filter, start, NULL);
+	}
 	return ;
 }
 
+/*
+ * A spring trigger during a motion turns it toward the end of the new
+ * direction, keeping the current position and velocity of every channel.
+ */
+static bool retarget_spring(motion_filter_data_t *filter, bool forward)
+{
+	variation_data_t *var = &filter->variation;
+	float value[CHANNEL_COUNT];
+	float velocity[CHANNEL_COUNT];
+
+	if (filter->motion_behavior == BEHAVIOR_ROUND_TRIP)
+		filter->motion_end = !forward;
+	else if (!forward)
+		return false;
+
+	eval_spring(var, value, velocity);
+	start_spring(filter, value, velocity);
+	return true;
+}
+
 static void reset_source_name(void *data, obs_sceneitem_t *item)
 {
 	motion_filter_data_t *filter = data;
@@ -241,57 +620,242 @@ static void reset_source_name(void *data, obs_sceneitem_t *item)
 
 static void recover_source(motion_filter_data_t *filter)
 {
-	struct vec2 pos;
-	struct vec2 scale;
+	float start[CHANNEL_COUNT];
 	obs_data_t *settings;
 	variation_data_t *var = &filter->variation;
 
 	if (!filter->motion_end)
 		return;
 
-	pos.x = var->point_x[0];
-	pos.y = var->point_y[0];
-	scale.x = var->scale_x[0];
-	scale.y = var->scale_y[0];
+	for (int i = 0; i < CHANNEL_COUNT; i++)
+		start[i] = var->points[i][0];
 
-	obs_sceneitem_set_pos(filter->item, &pos);
-	obs_sceneitem_set_scale(filter->item, &scale);
+	set_item_channels(filter->item, start,
+		filter->channels | VARIATION_ALWAYS);
 	filter->motion_end = false;
 	settings = obs_source_get_settings(filter->context);
 	obs_data_set_bool(settings, S_MOTION_END, false);
 	obs_data_release(settings);
 }
 
-static bool motion_init(void *data, bool forward)
+static bool start_motion(motion_filter_data_t *filter)
 {
-	motion_filter_data_t *filter = data;
-
-	if (filter->motion_start || is_reverse(filter) == forward)
-		return false;
+	uint64_t start = os_gettime_ns();
 
 	filter->item = get_item(filter->context, filter->item_name);
 
 	if (!filter->item) {
 		filter->item = get_item_by_id(filter->context, filter->item_id);
-		reset_source_name(data, filter->item);
+		reset_source_name(filter, filter->item);
 	}
 
 	if (filter->item) {
 		update_variation_data(filter);
 		obs_sceneitem_addref(filter->item);
 		filter->motion_start = true;
+		motion_trace_event("motion_init", filter->context, start,
+			os_gettime_ns());
 		return true;
 	}
 	return false;
 }
 
+/* puts the item back where the cycle started; reported from the next tick */
+static void stop_cycle(motion_filter_data_t *filter)
+{
+	variation_data_t *var = &filter->variation;
+	float start[CHANNEL_COUNT];
+
+	for (int i = 0; i < CHANNEL_COUNT; i++)
+		start[i] = var->points[i][0];
+
+	set_item_channels(filter->item, start,
+		filter->channels | VARIATION_ALWAYS);
+	obs_sceneitem_release(filter->item);
+	filter->motion_start = false;
+	filter->phase = 0.0;
+	os_atomic_set_bool(&filter->stop_pending, true);
+}
+
+/*
+ * The item lookup and the curve set up happen once per start, after which
+ * a cycle only advances the phase clock, so it runs indefinitely without
+ * touching the settings.
+ */
+static bool cycle_init(motion_filter_data_t *filter, bool forward)
+{
+	if (!forward) {
+		if (!filter->motion_start)
+			return false;
+		stop_cycle(filter);
+		return true;
+	}
+
+	if (filter->motion_start)
+		return false;
+
+	filter->phase = 0.0;
+	return start_motion(filter);
+}
+
+static bool motion_init(void *data, bool forward)
+{
+	motion_filter_data_t *filter = data;
+
+	motion_trace_instant("trigger", filter->context);
+
+	/* values staged this frame are from before the trigger */
+	filter->staged = false;
+
+	if (is_cyclic(filter))
+		return cycle_init(filter, forward);
+
+	if (filter->motion_start && use_spring(&filter->variation))
+		return retarget_spring(filter, forward);
+
+	if (filter->motion_start || is_reverse(filter) == forward)
+		return false;
+
+	return start_motion(filter);
+}
+
+static void get_record_item(motion_filter_data_t *filter,
+	struct motion_record_item *rec)
+{
+	obs_sceneitem_t *item = get_item(filter->context, filter->item_name);
+
+	if (!item)
+		item = get_item_by_id(filter->context, filter->item_id);
+
+	if (item) {
+		obs_source_t *source = obs_sceneitem_get_source(item);
+
+		rec->found = true;
+		rec->num_values = CHANNEL_COUNT;
+		get_item_channels(item, rec->values);
+		rec->width = obs_source_get_width(source);
+		rec->height = obs_source_get_height(source);
+	}
+}
+
+/*
+ * Common entry for hotkeys, buttons and scene switches. With recording on,
+ * the item state the motion starts from and the outcome are logged.
+ */
+static bool trigger_motion(motion_filter_data_t *filter,
+	enum motion_trigger trigger, bool forward)
+{
+	struct motion_record_item item = { 0 };
+	bool started;
+
+	if (filter->record)
+		get_record_item(filter, &item);
+
+	started = motion_init(filter, forward);
+
+	if (filter->record)
+		motion_record_trigger(filter->record_id, trigger, forward,
+			started, &item);
+	return started;
+}
+
+/* the stop is reported to sequences from the next tick */
+static void leave_scene(motion_filter_data_t *filter)
+{
+	struct motion_record_item item = { 0 };
+
+	if (filter->record)
+		get_record_item(filter, &item);
+
+	if (filter->motion_start)
+		os_atomic_set_bool(&filter->stop_pending, true);
+	filter->motion_start = false;
+	filter->motion_end = true;
+	recover_source(filter);
+
+	if (filter->record)
+		motion_record_trigger(filter->record_id, TRIGGER_SCENE_LEAVE,
+			false, false, &item);
+}
+
+static void proc_trigger(motion_filter_data_t *filter, bool forward)
+{
+	bool started = trigger_motion(filter, TRIGGER_PROC, forward);
+
+	motion_trigger_notify(filter->context, started ? MOTION_STARTED :
+		MOTION_REFUSED);
+}
+
+/*
+ * Batch, proc and sequence triggers, on the video thread, and only ever
+ * from there, which lets them report back to sequences directly.
+ */
+static void queued_trigger(void *data, bool forward)
+{
+	proc_trigger(data, forward);
+}
+
+/*
+ * Hotkeys, buttons and frontend events arrive on threads of their own and
+ * are moved to the video thread, where the pool has finished evaluating
+ * and nothing else reads the motion.
+ */
+static void hotkey_trigger(void *data, bool forward)
+{
+	trigger_motion(data, TRIGGER_HOTKEY, forward);
+}
+
+static void button_trigger(void *data, bool forward)
+{
+	trigger_motion(data, TRIGGER_BUTTON, forward);
+}
+
+static void switch_trigger(void *data, bool forward)
+{
+	trigger_motion(data, TRIGGER_SCENE_SWITCH, forward);
+}
+
+static void leave_trigger(void *data, bool forward)
+{
+	UNUSED_PARAMETER(forward);
+	leave_scene(data);
+}
+
+static void defer_trigger(motion_filter_data_t *filter,
+	motion_trigger_func func, bool forward)
+{
+	if (!motion_trigger_defer(filter->context, func, filter, forward))
+		blog(LOG_WARNING, "[motion-effect] trigger queue full, "
+			"trigger for '%s' dropped",
+			obs_source_get_name(filter->context));
+}
+
+static void query_state(void *data, struct motion_trigger_state *state)
+{
+	motion_filter_data_t *filter = data;
+	variation_data_t *var = &filter->variation;
+
+	state->running = filter->motion_start;
+	state->at_end = filter->motion_end;
+
+	if (state->running && is_cyclic(filter))
+		state->progress = cycle_period(filter) > 0.0 ?
+			(float)(filter->phase / cycle_period(filter)) : 1.0f;
+	else if (!state->running)
+		state->progress = state->at_end ? 1.0f : 0.0f;
+	else if (var->duration > 0.0f && var->elapsed_time < var->duration)
+		state->progress = var->elapsed_time / var->duration;
+	else
+		state->progress = 1.0f;
+}
+
 static void hotkey_forward(void *data, obs_hotkey_pair_id id,
 	obs_hotkey_t *hotkey, bool pressed)
 {
 	UNUSED_PARAMETER(id);
 	UNUSED_PARAMETER(hotkey);
 	UNUSED_PARAMETER(pressed);
-	motion_init(data, true);
+	defer_trigger(data, hotkey_trigger, true);
 }
 
 static void hotkey_backward(void *data, obs_hotkey_pair_id id,
@@ -300,7 +864,7 @@ static void hotkey_backward(void *data, obs_hotkey_pair_id id,
 	UNUSED_PARAMETER(id);
 	UNUSED_PARAMETER(hotkey);
 	UNUSED_PARAMETER(pressed);
-	motion_init(data, false);
+	defer_trigger(data, hotkey_trigger, false);
 }
 
 static void scene_change(enum obs_frontend_event event, void *data)
@@ -319,19 +883,17 @@ static void scene_change(enum obs_frontend_event event, void *data)
 	self_scene = obs_filter_get_parent(filter->context);
 
 	if (cur_scene == self_scene) {
-		motion_init(data, true);
+		defer_trigger(filter, switch_trigger, true);
 	} else if (is_program_scene(self_scene)) {
 		settings = obs_source_get_settings(filter->context);
 		self_name = obs_data_get_string(settings, S_SCENE_NAME);
 		cur_name = obs_source_get_name(cur_scene);
 		if (self_name && cur_name && strcmp(self_name, cur_name)==0) {
-			motion_init(data, true);
+			defer_trigger(filter, switch_trigger, true);
 		}
 		obs_data_release(settings);
 	} else {
-		filter->motion_start = false;
-		filter->motion_end = true;
-		recover_source(filter);
+		defer_trigger(filter, leave_trigger, false);
 	}
 	obs_source_release(cur_scene);
 }
@@ -341,10 +903,8 @@ static void set_reverse_info(struct motion_filter_data *filter)
 	variation_data_t *var = &filter->variation;
 	obs_data_t *settings = obs_source_get_settings(filter->context);
 	obs_data_set_bool(settings, S_MOTION_END, filter->motion_end);
-	obs_data_set_double(settings, S_ORG_X, var->point_x[0]);
-	obs_data_set_double(settings, S_ORG_Y, var->point_y[0]);
-	obs_data_set_double(settings, S_ORG_W, var->scale_x[0]);
-	obs_data_set_double(settings, S_ORG_H, var->scale_y[0]);
+	for (int i = 0; i < CHANNEL_COUNT; i++)
+		obs_data_set_double(settings, org_keys[i], var->points[i][0]);
 	obs_data_release(settings);
 }
 
@@ -353,10 +913,9 @@ static void get_reverse_info(struct motion_filter_data *filter)
 	variation_data_t *var = &filter->variation;
 	obs_data_t *settings = obs_source_get_settings(filter->context);
 	filter->motion_end = obs_data_get_bool(settings, S_MOTION_END);
-	var->point_x[0] = (float)obs_data_get_double(settings, S_ORG_X);
-	var->point_y[0] = (float)obs_data_get_double(settings, S_ORG_Y);
-	var->scale_x[0] = (float)obs_data_get_double(settings, S_ORG_W);
-	var->scale_y[0] = (float)obs_data_get_double(settings, S_ORG_H);
+	for (int i = 0; i < CHANNEL_COUNT; i++)
+		var->points[i][0] = (float)obs_data_get_double(settings,
+			org_keys[i]);
 	obs_data_release(settings);
 }
 
@@ -376,6 +935,9 @@ static void motion_filter_update(void *data, obs_data_t *settings)
 {
 	motion_filter_data_t *filter = data;
 	bool use_start, change_pos, change_size, scene_switch;
+	struct motion_curve_params params;
+	const struct motion_curve *curve;
+	uint32_t channels;
 	int var_type;
 	int64_t item_id;
 	const char *item_name;
@@ -395,7 +957,29 @@ static void motion_filter_update(void *data, obs_data_t *settings)
 	filter->dst_pos.y = (float)obs_data_get_int(settings, S_DST_Y);
 	filter->dst_width = (int)obs_data_get_int(settings, S_DST_W);
 	filter->dst_height = (int)obs_data_get_int(settings, S_DST_H);
+	filter->dst_rot = (float)obs_data_get_double(settings, S_DST_ROT);
+	filter->dst_bounds.x = (float)obs_data_get_int(settings, S_DST_BOUNDS_W);
+	filter->dst_bounds.y = (float)obs_data_get_int(settings, S_DST_BOUNDS_H);
+	filter->dst_crop.left = (int)obs_data_get_int(settings, S_DST_CROP_LEFT);
+	filter->dst_crop.top = (int)obs_data_get_int(settings, S_DST_CROP_TOP);
+	filter->dst_crop.right = (int)obs_data_get_int(settings, S_DST_CROP_RIGHT);
+	filter->dst_crop.bottom = (int)obs_data_get_int(settings,
+		S_DST_CROP_BOTTOM);
 	filter->acceleration = (float)obs_data_get_double(settings, S_ACCELERATION);
+	filter->spring_frequency = (float)obs_data_get_double(settings,
+		S_SPRING_FREQUENCY);
+	filter->spring_damping = (float)obs_data_get_double(settings,
+		S_SPRING_DAMPING);
+	filter->spring_settle = (float)obs_data_get_double(settings,
+		S_SPRING_SETTLE);
+	if (filter->spring_frequency < 0.1f)
+		filter->spring_frequency = 0.1f;
+
+	get_curve_params(filter, &params);
+	curve = motion_curve_get(&params);
+	motion_curve_release(filter->curve);
+	filter->curve = curve;
+
 	use_start = obs_data_get_bool(settings, S_START_SETTING);
 	var_type = (int)obs_data_get_int(settings, S_VARIATION_TYPE);
 	item_name = obs_data_get_string(settings, S_SOURCE);
@@ -408,13 +992,26 @@ static void motion_filter_update(void *data, obs_data_t *settings)
 
 	filter->use_start_position = (scene_switch || use_start) && change_pos;
 	filter->use_start_scale = (scene_switch || use_start) && change_size;
-	filter->change_position = change_pos;
-	filter->change_size = change_size;
+
+	channels = (uint32_t)var_type & (VARIATION_POSITION | VARIATION_SIZE);
+	if (obs_data_get_bool(settings, S_CHANGE_ROT))
+		channels |= VARIATION_ROTATION;
+	if (obs_data_get_bool(settings, S_CHANGE_BOUNDS))
+		channels |= VARIATION_BOUNDS;
+	if (obs_data_get_bool(settings, S_CHANGE_CROP))
+		channels |= VARIATION_CROP;
+	filter->channels = channels;
 
 
 	bfree(filter->item_name);
 	filter->item_name = bstrdup(item_name);
 	filter->item_id = item_id;
+
+	filter->record = obs_data_get_bool(settings, S_RECORD);
+	if (filter->record)
+		motion_record_filter(filter->record_id, filter->context,
+			settings, record_keys,
+			sizeof(record_keys) / sizeof(record_keys[0]));
 }
 
 static bool register_trigger_event(void *data)
@@ -435,7 +1032,7 @@ static bool register_trigger_event(void *data)
 	filter->hotkey_id_f = register_hotkey(filter->context, source, S_FORWARD,
 		T_FORWARD, hotkey_forward, data);
 
-	if (filter->motion_behavior == BEHAVIOR_ROUND_TRIP) {
+	if (has_backward(filter)) {
 		filter->hotkey_id_b = register_hotkey(filter->context, source, 
 			S_BACKWARD, T_BACKWARD, hotkey_backward, data);
 	}
@@ -476,11 +1073,13 @@ static bool motion_set_button(obs_properties_t *props, obs_property_t *p,
 	return true;
 }
 
+/* the motion starts on the next frame, the buttons flip as if it had */
 static bool forward_clicked(obs_properties_t *props, obs_property_t *p,
 	void *data)
 {
 	motion_filter_data_t *filter = data;
-	if (motion_init(data, true) && filter->motion_behavior == BEHAVIOR_ROUND_TRIP)
+	defer_trigger(filter, button_trigger, true);
+	if (has_backward(filter))
 		return motion_set_button(props, p, true);
 	else
 		return false;
@@ -489,10 +1088,8 @@ static bool forward_clicked(obs_properties_t *props, obs_property_t *p,
 static bool backward_clicked(obs_properties_t *props, obs_property_t *p,
 	void *data)
 {
-	if (motion_init(data, false))
-		return motion_set_button(props, p, false);
-	else
-		return false;
+	defer_trigger(data, button_trigger, false);
+	return motion_set_button(props, p, false);
 }
 
 static bool source_changed(void *data, obs_properties_t *props, 
@@ -545,21 +1142,36 @@ static bool properties_set_vis(void *data, obs_properties_t *props,
 	bool change_pos = (var_type & VARIATION_POSITION) != 0;
 	bool change_size = (var_type & VARIATION_SIZE) != 0;
 	bool scene_switch = trigger_type == BEHAVIOR_SCENE_SWITCH;
+	bool change_bounds = obs_data_get_bool(s, S_CHANGE_BOUNDS);
+	bool change_crop = obs_data_get_bool(s, S_CHANGE_CROP);
 
 	set_visibility(S_START_SETTING, !scene_switch);
 	set_visibility(S_START_X, change_pos && (use_start || scene_switch));
 	set_visibility(S_START_Y, change_pos && (use_start || scene_switch));
 	set_visibility(S_DST_X, change_pos);
 	set_visibility(S_DST_Y, change_pos);
-	set_visibility(S_PATH_TYPE, change_pos);
-	set_visibility(S_CTRL_X, change_pos && path_type >= PATH_QUADRATIC);
-	set_visibility(S_CTRL_Y, change_pos && path_type >= PATH_QUADRATIC);
-	set_visibility(S_CTRL2_X, change_pos && path_type >= PATH_CUBIC);
-	set_visibility(S_CTRL2_Y, change_pos && path_type >= PATH_CUBIC);
+	set_visibility(S_CTRL_X, change_pos && (path_type == PATH_QUADRATIC ||
+		path_type == PATH_CUBIC));
+	set_visibility(S_CTRL_Y, change_pos && (path_type == PATH_QUADRATIC ||
+		path_type == PATH_CUBIC));
+	set_visibility(S_CTRL2_X, change_pos && path_type == PATH_CUBIC);
+	set_visibility(S_CTRL2_Y, change_pos && path_type == PATH_CUBIC);
+	set_visibility(S_DURATION, path_type != PATH_SPRING);
+	set_visibility(S_ACCELERATION, path_type != PATH_SPRING);
+	set_visibility(S_SPRING_FREQUENCY, path_type == PATH_SPRING);
+	set_visibility(S_SPRING_DAMPING, path_type == PATH_SPRING);
+	set_visibility(S_SPRING_SETTLE, path_type == PATH_SPRING);
 	set_visibility(S_START_W, change_size && (use_start || scene_switch));
 	set_visibility(S_START_H, change_size && (use_start || scene_switch));
 	set_visibility(S_DST_W, change_size);
 	set_visibility(S_DST_H, change_size);
+	set_visibility(S_DST_ROT, obs_data_get_bool(s, S_CHANGE_ROT));
+	set_visibility(S_DST_BOUNDS_W, change_bounds);
+	set_visibility(S_DST_BOUNDS_H, change_bounds);
+	set_visibility(S_DST_CROP_LEFT, change_crop);
+	set_visibility(S_DST_CROP_TOP, change_crop);
+	set_visibility(S_DST_CROP_RIGHT, change_crop);
+	set_visibility(S_DST_CROP_BOTTOM, change_crop);
 
 	UNUSED_PARAMETER(p);
 	return true;
@@ -571,6 +1183,8 @@ static bool motion_behavior_changed(void *data, obs_properties_t *props,
 	motion_filter_data_t *filter = data;
 	int behavior = (int)obs_data_get_int(s, S_MOTION_BEHAVIOR);
 	if (behavior != filter->motion_behavior) {
+		if (filter->motion_start && is_cyclic(filter))
+			stop_cycle(filter);
 		recover_source(filter);
 		unregister_trigger_event(data);
 		filter->motion_behavior = behavior;
@@ -594,8 +1208,10 @@ static bool dest_grab_current_position_clicked(obs_properties_t *props,
 
 	if (item) {
 		struct obs_transform_info info;
+		struct obs_sceneitem_crop crop;
 		int width, height;
 		obs_sceneitem_get_info(item, &info);
+		obs_sceneitem_get_crop(item, &crop);
 		cal_size(item, info.scale.x, info.scale.y, &width, &height);
 		// Set setting property values to match the source's current position
 		obs_data_t *settings = obs_source_get_settings(filter->context);
@@ -603,6 +1219,13 @@ static bool dest_grab_current_position_clicked(obs_properties_t *props,
 		obs_data_set_int(settings, S_DST_Y, (int)info.pos.y);
 		obs_data_set_int(settings, S_DST_W, width);
 		obs_data_set_int(settings, S_DST_H, height);
+		obs_data_set_double(settings, S_DST_ROT, info.rot);
+		obs_data_set_int(settings, S_DST_BOUNDS_W, (int)info.bounds.x);
+		obs_data_set_int(settings, S_DST_BOUNDS_H, (int)info.bounds.y);
+		obs_data_set_int(settings, S_DST_CROP_LEFT, crop.left);
+		obs_data_set_int(settings, S_DST_CROP_TOP, crop.top);
+		obs_data_set_int(settings, S_DST_CROP_RIGHT, crop.right);
+		obs_data_set_int(settings, S_DST_CROP_BOTTOM, crop.bottom);
 		obs_data_release(settings);
 		return true;
 	}
@@ -622,6 +1245,7 @@ static obs_properties_t *motion_filter_properties(void *data)
 	obs_properties_t *props = obs_properties_create();
 	obs_property_t *p;
 	struct dstr disable_str = { 0 };
+	bool reversed;
 
 	obs_source_t *source = obs_filter_get_parent(filter->context);
 	obs_scene_t *scene = obs_scene_from_source(source);
@@ -648,6 +1272,8 @@ static obs_properties_t *motion_filter_properties(void *data)
 	obs_property_list_add_int(p, T_HOTKEY_ONE_WAY, BEHAVIOR_ONE_WAY);
 	obs_property_list_add_int(p, T_HOTKEY_ROUND_TRIP, BEHAVIOR_ROUND_TRIP);
 	obs_property_list_add_int(p, T_SCENE_SWITCH, BEHAVIOR_SCENE_SWITCH);
+	obs_property_list_add_int(p, T_LOOP, BEHAVIOR_LOOP);
+	obs_property_list_add_int(p, T_PING_PONG, BEHAVIOR_PING_PONG);
 	// Using modified_callback2 enables us to send along data into the callback
 	obs_property_set_modified_callback2(p, motion_behavior_changed, filter);
 
@@ -679,6 +1305,7 @@ static obs_properties_t *motion_filter_properties(void *data)
 	obs_property_list_add_int(p, T_PATH_LINEAR, PATH_LINEAR);
 	obs_property_list_add_int(p, T_PATH_QUADRATIC, PATH_QUADRATIC);
 	obs_property_list_add_int(p, T_PATH_CUBIC, PATH_CUBIC);
+	obs_property_list_add_int(p, T_PATH_SPRING, PATH_SPRING);
 	obs_property_set_modified_callback2(p, properties_set_vis,filter);
 
 	// Button that pre-populates destination position with the source's current position
@@ -700,6 +1327,30 @@ static obs_properties_t *motion_filter_properties(void *data)
 	obs_properties_add_int(props, S_DST_W, T_DST_W, 0, 8192, 1);
 	obs_properties_add_int(props, S_DST_H, T_DST_H, 0, 8192, 1);
 
+	// Rotation, bounding box and crop, each animated when checked
+	p = obs_properties_add_bool(props, S_CHANGE_ROT, T_CHANGE_ROT);
+	obs_property_set_modified_callback2(p, properties_set_vis, filter);
+	obs_properties_add_float(props, S_DST_ROT, T_DST_ROT, -3600.0, 3600.0,
+		0.1);
+
+	p = obs_properties_add_bool(props, S_CHANGE_BOUNDS, T_CHANGE_BOUNDS);
+	obs_property_set_modified_callback2(p, properties_set_vis, filter);
+	obs_properties_add_int(props, S_DST_BOUNDS_W, T_DST_BOUNDS_W, 0, 8192,
+		1);
+	obs_properties_add_int(props, S_DST_BOUNDS_H, T_DST_BOUNDS_H, 0, 8192,
+		1);
+
+	p = obs_properties_add_bool(props, S_CHANGE_CROP, T_CHANGE_CROP);
+	obs_property_set_modified_callback2(p, properties_set_vis, filter);
+	obs_properties_add_int(props, S_DST_CROP_LEFT, T_DST_CROP_LEFT, 0,
+		8192, 1);
+	obs_properties_add_int(props, S_DST_CROP_TOP, T_DST_CROP_TOP, 0, 8192,
+		1);
+	obs_properties_add_int(props, S_DST_CROP_RIGHT, T_DST_CROP_RIGHT, 0,
+		8192, 1);
+	obs_properties_add_int(props, S_DST_CROP_BOTTOM, T_DST_CROP_BOTTOM, 0,
+		8192, 1);
+
 	// Animation duration slider
 	obs_properties_add_float_slider(props, S_DURATION, T_DURATION, 0, 5, 
 		0.1);
@@ -708,50 +1359,109 @@ static obs_properties_t *motion_filter_properties(void *data)
 	obs_properties_add_float_slider(props, S_ACCELERATION, T_ACCELERATION, -1, 
 		1, 0.01);
 
+	// Spring stiffness, damping and when it counts as settled
+	obs_properties_add_float_slider(props, S_SPRING_FREQUENCY,
+		T_SPRING_FREQUENCY, 0.1, 10.0, 0.1);
+	obs_properties_add_float_slider(props, S_SPRING_DAMPING,
+		T_SPRING_DAMPING, 0.05, 1.0, 0.01);
+	obs_properties_add_float_slider(props, S_SPRING_SETTLE, T_SPRING_SETTLE,
+		0.01, 10.0, 0.01);
+
+	// Log triggers and results for offline replay
+	obs_properties_add_bool(props, S_RECORD, T_RECORD);
+
 	// Forwards / Backwards button(s)
+	reversed = is_reverse(filter) ||
+		(is_cyclic(filter) && filter->motion_start);
 	p = obs_properties_add_button(props, S_FORWARD, T_FORWARD, forward_clicked);
-	obs_property_set_visible(p, !is_reverse(filter));
+	obs_property_set_visible(p, !reversed);
 	p =obs_properties_add_button(props, S_BACKWARD, T_BACKWARD, backward_clicked);
-	obs_property_set_visible(p, is_reverse(filter));
+	obs_property_set_visible(p, reversed);
 
 	return props;
 }
 
+/*
+ * A cycle is the forward motion evaluated at the phase clock. A ping-pong
+ * retraces it backward in its second half, except on a spring path, which
+ * heads back from rest as the mirror image of the way out.
+ */
+static void cycle_variation(motion_filter_data_t *filter)
+{
+	variation_data_t *var = &filter->variation;
+	double duration = var->duration;
+	double t = filter->phase;
+	bool back = t > duration;
+
+	if (use_spring(var)) {
+		var->elapsed_time = (float)(back ? t - duration : t);
+		eval_spring(var, var->value, NULL);
+		if (back) {
+			for (int i = 0; i < CHANNEL_COUNT; i++)
+				var->value[i] = var->points[i][0] +
+					var->target[i] - var->value[i];
+		}
+	} else {
+		float coeff = 1.0f;
+
+		if (duration > 0.0)
+			coeff = (float)((back ? 2.0 * duration - t : t) /
+				duration);
+		coeff = motion_curve_ease(var->curve, coeff);
+
+		for (int i = 0; i < CHANNEL_COUNT; i++)
+			var->value[i] = bezier(var->points[i], coeff,
+				var->order[i]);
+	}
+}
+
 static void cal_variation(motion_filter_data_t *filter)
 {
 	variation_data_t *var = &filter->variation;
 
-	float elapsed_time = fmin(filter->duration, var->elapsed_time);
+	float elapsed_time = fmin(var->duration, var->elapsed_time);
 	float coeff;
-	int order;
 
-	if (filter->duration <= 0)
-		coeff = 1.0f;
-	else if (is_reverse(filter)) 
-		coeff = 1.0f - (elapsed_time / filter->duration);
-	else 
-		coeff = elapsed_time / filter->duration;
-
-	if (var->coeff_varaite)
-		coeff = bezier(var->coeff, coeff, 2);
+	if (is_cyclic(filter)) {
+		cycle_variation(filter);
+	} else if (use_spring(var)) {
+		eval_spring(var, var->value, NULL);
+	} else {
+		if (var->duration <= 0)
+			coeff = 1.0f;
+		else if (is_reverse(filter)) 
+			coeff = 1.0f - (elapsed_time / var->duration);
+		else 
+			coeff = elapsed_time / var->duration;
+
+		coeff = motion_curve_ease(var->curve, coeff);
+
+		for (int i = 0; i < CHANNEL_COUNT; i++)
+			var->value[i] = bezier(var->points[i], coeff,
+				var->order[i]);
+	}
 
-	order = filter->change_size ? 1 : 0;
-	
-	var->scale.x = bezier(var->scale_x, coeff, order);
-	var->scale.y = bezier(var->scale_y, coeff, order);
+	var->position.x = var->value[CHANNEL_POS_X];
+	var->position.y = var->value[CHANNEL_POS_Y];
+	var->scale.x = var->value[CHANNEL_SCALE_X];
+	var->scale.y = var->value[CHANNEL_SCALE_Y];
+}
 
+static bool motion_filter_ready(void *data)
+{
+	motion_filter_data_t *filter = data;
+	return filter->motion_start;
+}
 
-	if (!filter->change_position)
-		order = 0;
-	else if (filter->path_type == PATH_QUADRATIC)
-		order = 2;
-	else if (filter->path_type == PATH_CUBIC)
-		order = 3;
-	else 
-		order = 1;
+/* the runtime's parallel evaluate phase, before sources tick */
+static void motion_filter_evaluate(void *data)
+{
+	motion_filter_data_t *filter = data;
+	uint64_t start = os_gettime_ns();
 
-	var->position.x = bezier(var->point_x, coeff, order);
-	var->position.y = bezier(var->point_y, coeff, order);
+	cal_variation(filter);
+	filter->staged_ns = os_gettime_ns() - start;
+	filter->staged = true;
 }
 
 static void motion_filter_tick(void *data, float seconds)
@@ -759,18 +1469,60 @@ static void motion_filter_tick(void *data, float seconds)
 	motion_filter_data_t *filter = data;
 	variation_data_t *var = &filter->variation;
 
+	if (os_atomic_load_bool(&filter->stop_pending)) {
+		os_atomic_set_bool(&filter->stop_pending, false);
+		motion_trigger_notify(filter->context, MOTION_FINISHED);
+	}
+
 	if (filter->motion_start) {
+		uint64_t start = os_gettime_ns();
+		uint64_t eval_ns, eval_end, commit_end;
+		int setters;
+
+		if (filter->staged) {
+			eval_ns = filter->staged_ns;
+			filter->staged = false;
+		} else {
+			cal_variation(filter);
+			eval_ns = os_gettime_ns() - start;
+			motion_trace_event("evaluate", filter->context, start,
+				start + eval_ns);
+		}
 
-		cal_variation(filter);
-		obs_sceneitem_set_pos(filter->item, &var->position);
-		obs_sceneitem_set_scale(filter->item, &var->scale);
+		eval_end = os_gettime_ns();
+		setters = set_item_channels(filter->item, var->value,
+			filter->channels | VARIATION_ALWAYS);
+		commit_end = os_gettime_ns();
+
+		motion_trace_event("commit", filter->context, eval_end,
+			commit_end);
+		motion_trace_frame(eval_ns + commit_end - eval_end);
+		motion_stat_record(&filter->stats.eval_ns, eval_ns);
+		motion_stat_record(&filter->stats.commit_ns,
+			commit_end - eval_end);
+		motion_stat_record(&filter->stats.items_touched, 1);
+		motion_stat_record(&filter->stats.setter_calls, setters);
+
+		if (filter->record) {
+			float committed[CHANNEL_COUNT];
+
+			get_item_channels(filter->item, committed);
+			motion_record_tick(filter->record_id, seconds,
+				committed, CHANNEL_COUNT,
+				eval_ns + commit_end - eval_end);
+		}
 
-		if (var->elapsed_time >= filter->duration) {
+		if (is_cyclic(filter)) {
+			double period = cycle_period(filter);
+			filter->phase = period > 0.0 ?
+				fmod(filter->phase + seconds, period) : 0.0;
+		} else if (var->elapsed_time >= var->duration) {
 			filter->motion_start = false;
 			var->elapsed_time = 0.0f;
 			obs_sceneitem_release(filter->item);
 			filter->motion_end = !filter->motion_end;
 			set_reverse_info(filter);
+			motion_trigger_notify(filter->context, MOTION_FINISHED);
 		} else
 			var->elapsed_time += seconds;
 	}
@@ -797,6 +1549,12 @@ static void *motion_filter_create(obs_data_t *settings, obs_source_t *context)
 	filter->path_type = PATH_LINEAR;
 	filter->hotkey_id_f = OBS_INVALID_HOTKEY_ID;
 	filter->hotkey_id_b = OBS_INVALID_HOTKEY_ID;
+	filter->record_id = motion_record_new_id();
+	motion_runtime_add_source(context, &filter->stats);
+	motion_trigger_add_filter(context, queued_trigger, query_state,
+		filter);
+	motion_runtime_add_evaluator(filter, motion_filter_ready,
+		motion_filter_evaluate);
 	get_reverse_info(filter);
 	obs_source_update(context, settings);
 	return filter;
@@ -806,6 +1564,8 @@ static void motion_filter_remove(void *data, obs_source_t *source)
 {
 	motion_filter_data_t *filter = data;
 	unregister_trigger_event(data);
+	if (filter->motion_start && is_cyclic(filter))
+		stop_cycle(filter);
 	recover_source(filter);
 	UNUSED_PARAMETER(source);
 }
@@ -813,6 +1573,11 @@ static void motion_filter_remove(void *data, obs_source_t *source)
 static void motion_filter_destroy(void *data)
 {
 	motion_filter_data_t *filter = data;
+	motion_runtime_remove_evaluator(filter);
+	motion_trigger_remove_filter(filter);
+	motion_runtime_remove_source(&filter->stats);
+	motion_curve_release(filter->variation.curve);
+	motion_curve_release(filter->curve);
 	bfree(filter->item_name);
 	bfree(filter);
 }
@@ -822,6 +1587,9 @@ static void motion_filter_defaults(obs_data_t *settings)
 	obs_data_set_default_bool(settings, S_MOTION_END, false);
 	obs_data_set_default_int(settings, S_MOTION_BEHAVIOR, BEHAVIOR_ROUND_TRIP);
 	obs_data_set_default_double(settings, S_DURATION, 1.0);
+	obs_data_set_default_double(settings, S_SPRING_FREQUENCY, 2.0);
+	obs_data_set_default_double(settings, S_SPRING_DAMPING, 1.0);
+	obs_data_set_default_double(settings, S_SPRING_SETTLE, 0.1);
 }
 
 static const char *motion_filter_get_name(void *unused)
@@ -830,9 +1598,6 @@ static const char *motion_filter_get_name(void *unused)
 	return T_("Motion");
 }
 
-OBS_DECLARE_MODULE()
-OBS_MODULE_USE_DEFAULT_LOCALE("motion-filter", "en-US")
-
 struct obs_source_info motion_filter = {
 	.id = "motion-filter",
 	.type = OBS_SOURCE_TYPE_FILTER,
@@ -847,9 +1612,3 @@ struct obs_source_info motion_filter = {
 	.save = motion_filter_save,
 	.filter_remove = motion_filter_remove
 };
-
-bool obs_module_load(void) {
-	obs_register_source(&motion_filter);
-	return true;
-}
-
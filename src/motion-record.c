@@ -0,0 +1,244 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+#include "motion-record.h"
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/threading.h>
+#include <stdio.h>
+
+#define RECORD_BUFFER_SIZE 65536
+#define RECORD_HEADER_SIZE 17
+
+struct record_buffer {
+	uint8_t             data[RECORD_BUFFER_SIZE];
+	size_t              size;
+	bool                overflow;
+};
+
+static pthread_mutex_t record_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct record_buffer buffer;
+static FILE *record_file;
+static bool record_failed;
+static volatile long next_id;
+
+static void put_bytes(const void *bytes, size_t size)
+{
+	if (buffer.size + size > RECORD_BUFFER_SIZE) {
+		buffer.overflow = true;
+		return;
+	}
+
+	memcpy(buffer.data + buffer.size, bytes, size);
+	buffer.size += size;
+}
+
+static void put_uint(uint64_t value, size_t size)
+{
+	uint8_t bytes[8];
+
+	for (size_t i = 0; i < size; i++)
+		bytes[i] = (uint8_t)(value >> (i * 8));
+	put_bytes(bytes, size);
+}
+
+static inline void put_u8(uint8_t value)   { put_uint(value, 1); }
+static inline void put_u16(uint16_t value) { put_uint(value, 2); }
+static inline void put_u32(uint32_t value) { put_uint(value, 4); }
+static inline void put_u64(uint64_t value) { put_uint(value, 8); }
+
+static void put_f32(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	put_u32(bits);
+}
+
+static void put_f64(double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	put_u64(bits);
+}
+
+static void put_str(const char *str)
+{
+	size_t len = str ? strlen(str) : 0;
+
+	if (len > 0xFFFF)
+		len = 0xFFFF;
+	put_u16((uint16_t)len);
+	put_bytes(str, len);
+}
+
+static void put_values(const float *values, size_t num_values)
+{
+	if (num_values > MOTION_RECORD_VALUES)
+		num_values = MOTION_RECORD_VALUES;
+	put_u8((uint8_t)num_values);
+	for (size_t i = 0; i < num_values; i++)
+		put_f32(values[i]);
+}
+
+static bool open_record_file(void)
+{
+	struct dstr name = { 0 };
+	uint8_t header[4] = { 0 };
+	char *dir, *path;
+
+	if (record_file)
+		return true;
+	if (record_failed)
+		return false;
+
+	dir = obs_module_config_path("");
+	if (dir) {
+		os_mkdirs(dir);
+		bfree(dir);
+	}
+
+	dstr_printf(&name, "motion-record-%llu.bin",
+		(unsigned long long)(os_gettime_ns() / 1000000));
+	path = obs_module_config_path(name.array);
+	dstr_free(&name);
+
+	record_file = path ? os_fopen(path, "wb") : NULL;
+	if (!record_file) {
+		blog(LOG_WARNING, "[motion-effect] failed to open record "
+			"file '%s'", path ? path : "");
+		record_failed = true;
+		bfree(path);
+		return false;
+	}
+
+	header[0] = (uint8_t)MOTION_RECORD_VERSION;
+	fwrite(MOTION_RECORD_MAGIC, 1, 4, record_file);
+	fwrite(header, 1, sizeof(header), record_file);
+
+	blog(LOG_INFO, "[motion-effect] recording triggers to '%s'", path);
+	bfree(path);
+	return true;
+}
+
+/* starts a record; the payload size is patched in by end_record */
+static void begin_record(enum motion_record_type type, uint32_t id)
+{
+	pthread_mutex_lock(&record_mutex);
+
+	buffer.size = 0;
+	buffer.overflow = false;
+	put_u8((uint8_t)type);
+	put_u32(id);
+	put_u64(os_gettime_ns());
+	put_u32(0);
+}
+
+static void end_record(bool flush)
+{
+	uint32_t payload = (uint32_t)(buffer.size - RECORD_HEADER_SIZE);
+
+	for (size_t i = 0; i < 4; i++)
+		buffer.data[RECORD_HEADER_SIZE - 4 + i] =
+			(uint8_t)(payload >> (i * 8));
+
+	if (buffer.overflow) {
+		blog(LOG_WARNING, "[motion-effect] record too large, dropped");
+	} else if (open_record_file()) {
+		fwrite(buffer.data, 1, buffer.size, record_file);
+		if (flush)
+			fflush(record_file);
+	}
+
+	pthread_mutex_unlock(&record_mutex);
+}
+
+uint32_t motion_record_new_id(void)
+{
+	return (uint32_t)os_atomic_inc_long(&next_id);
+}
+
+void motion_record_filter(uint32_t id, obs_source_t *source,
+	obs_data_t *settings, const struct motion_record_key *keys,
+	size_t num_keys)
+{
+	begin_record(RECORD_FILTER, id);
+	put_str(obs_source_get_name(source));
+	put_u16((uint16_t)num_keys);
+
+	for (size_t i = 0; i < num_keys; i++) {
+		const char *key = keys[i].name;
+
+		put_u8((uint8_t)keys[i].type);
+		put_str(key);
+
+		switch (keys[i].type) {
+		case RECORD_INT:
+			put_u64((uint64_t)obs_data_get_int(settings, key));
+			break;
+		case RECORD_DOUBLE:
+			put_f64(obs_data_get_double(settings, key));
+			break;
+		case RECORD_BOOL:
+			put_u8(obs_data_get_bool(settings, key));
+			break;
+		case RECORD_STRING:
+			put_str(obs_data_get_string(settings, key));
+			break;
+		}
+	}
+
+	end_record(true);
+}
+
+void motion_record_trigger(uint32_t id, enum motion_trigger trigger,
+	bool forward, bool started, const struct motion_record_item *item)
+{
+	begin_record(RECORD_TRIGGER, id);
+	put_u8((uint8_t)trigger);
+	put_u8(forward);
+	put_u8(started);
+	put_u8(item->found);
+	put_u32(item->width);
+	put_u32(item->height);
+	put_values(item->values, item->num_values);
+	end_record(true);
+}
+
+void motion_record_tick(uint32_t id, float seconds, const float *values,
+	size_t num_values, uint64_t cost_ns)
+{
+	begin_record(RECORD_TICK, id);
+	put_f32(seconds);
+	put_u32(cost_ns > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)cost_ns);
+	put_values(values, num_values);
+	end_record(false);
+}
+
+void motion_record_free(void)
+{
+	pthread_mutex_lock(&record_mutex);
+	if (record_file) {
+		fclose(record_file);
+		record_file = NULL;
+	}
+	record_failed = false;
+	pthread_mutex_unlock(&record_mutex);
+}
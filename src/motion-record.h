@@ -0,0 +1,97 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+#pragma once
+
+#include <obs-module.h>
+
+/*
+ * Trigger recorder for motion filters with recording enabled. Every filter
+ * setting change, trigger and committed tick is appended to one binary
+ * file per session in the plugin config directory, which the headless
+ * replayer (bench/filter-replay) re-drives and verifies.
+ *
+ * File layout, all values little-endian:
+ *
+ *   header   "MREC" u32 version
+ *   record   u8 type, u32 filter id, u64 timestamp ns, u32 payload size,
+ *            payload
+ *
+ *   RECORD_FILTER   str filter name, u16 count, count x (u8 value type,
+ *                   str key, value), value is i64 / f64 / u8 / str
+ *   RECORD_TRIGGER  u8 trigger, u8 forward, u8 started, u8 item found,
+ *                   u32 width/height, u8 count, count x f32 value
+ *   RECORD_TICK     f32 seconds, u32 cost ns, u8 count, count x f32 value
+ *
+ * where str is a u16 length followed by that many bytes, and the values
+ * are the item's animated channels in the filter's channel order: pos
+ * x/y, scale x/y, rotation, bounds x/y, crop left/top/right/bottom.
+ */
+
+#define MOTION_RECORD_MAGIC   "MREC"
+#define MOTION_RECORD_VERSION 2
+#define MOTION_RECORD_VALUES  16
+
+enum motion_record_type {
+	RECORD_FILTER = 1,
+	RECORD_TRIGGER = 2,
+	RECORD_TICK = 3
+};
+
+enum motion_record_value {
+	RECORD_INT = 0,
+	RECORD_DOUBLE = 1,
+	RECORD_BOOL = 2,
+	RECORD_STRING = 3
+};
+
+enum motion_trigger {
+	TRIGGER_HOTKEY = 0,
+	TRIGGER_BUTTON = 1,
+	TRIGGER_SCENE_SWITCH = 2,
+	TRIGGER_SCENE_LEAVE = 3,
+	TRIGGER_PROC = 4
+};
+
+struct motion_record_key {
+	const char                *name;
+	enum motion_record_value  type;
+};
+
+/* item state right before a trigger, so a replay starts from the same place */
+struct motion_record_item {
+	bool                found;
+	uint32_t            width;
+	uint32_t            height;
+	size_t              num_values;
+	float               values[MOTION_RECORD_VALUES];
+};
+
+uint32_t motion_record_new_id(void);
+void motion_record_free(void);
+
+void motion_record_filter(uint32_t id, obs_source_t *source,
+	obs_data_t *settings, const struct motion_record_key *keys,
+	size_t num_keys);
+void motion_record_trigger(uint32_t id, enum motion_trigger trigger,
+	bool forward, bool started, const struct motion_record_item *item);
+void motion_record_tick(uint32_t id, float seconds, const float *values,
+	size_t num_values, uint64_t cost_ns);
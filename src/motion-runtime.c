@@ -0,0 +1,258 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#include "motion-runtime.h"
+#include "motion-trace.h"
+#include "motion-record.h"
+#include "motion-trigger.h"
+#include "motion-control.h"
+#include "thread-pool.h"
+#include "epoch.h"
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define PARALLEL_MIN_MOTIONS 16
+#define EVAL_CHUNK_SIZE      4
+
+struct runtime_source {
+	struct runtime_source *next;
+	obs_source_t        *source;
+	struct motion_stats *stats;
+};
+
+struct runtime_evaluator {
+	struct runtime_evaluator *next;
+	void                *data;
+	motion_eval_ready_t ready;
+	motion_eval_t       eval;
+};
+
+static pthread_mutex_t sources_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct runtime_source *sources;
+static bool initialized;
+
+static pthread_mutex_t evaluators_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct runtime_evaluator *evaluators;
+
+/* video thread only */
+static struct runtime_evaluator **in_flight;
+static size_t in_flight_capacity;
+
+static void evaluate_task(void *param, size_t start, size_t end)
+{
+	for (size_t i = start; i < end; i++)
+		in_flight[i]->eval(in_flight[i]->data);
+
+	UNUSED_PARAMETER(param);
+}
+
+/*
+ * Phase one of a frame: with enough motions in flight, evaluate them all
+ * on the pool. With fewer, handing them out costs more than it saves and
+ * nothing is staged, so each source evaluates in its own tick. The lock
+ * keeps sources from being destroyed while the workers use them; motions
+ * are only started and stopped on the video thread, so nothing else
+ * writes them meanwhile.
+ */
+static void evaluate_motions(void)
+{
+	struct runtime_evaluator *ev;
+	size_t count = 0;
+	uint64_t start;
+
+	pthread_mutex_lock(&evaluators_mutex);
+
+	for (ev = evaluators; ev; ev = ev->next) {
+		if (!ev->ready(ev->data))
+			continue;
+
+		if (count == in_flight_capacity) {
+			in_flight_capacity = in_flight_capacity ?
+				in_flight_capacity * 2 : 64;
+			in_flight = brealloc(in_flight, sizeof(*in_flight) *
+				in_flight_capacity);
+		}
+		in_flight[count++] = ev;
+	}
+
+	if (count >= PARALLEL_MIN_MOTIONS) {
+		start = os_gettime_ns();
+		thread_pool_run(count, EVAL_CHUNK_SIZE, evaluate_task, NULL);
+		motion_trace_event("evaluate (parallel)", NULL, start,
+			os_gettime_ns());
+	}
+
+	pthread_mutex_unlock(&evaluators_mutex);
+}
+
+static void runtime_tick(void *param, float seconds)
+{
+	struct runtime_source *rs;
+
+	evaluate_motions();
+
+	pthread_mutex_lock(&sources_mutex);
+	for (rs = sources; rs; rs = rs->next)
+		motion_stats_tick(rs->source, rs->stats);
+	pthread_mutex_unlock(&sources_mutex);
+
+	epoch_reclaim();
+
+	UNUSED_PARAMETER(param);
+	UNUSED_PARAMETER(seconds);
+}
+
+static void get_motion_effect_stats(void *data, calldata_t *cd)
+{
+	obs_data_t *json = obs_data_create();
+	obs_data_array_t *array = obs_data_array_create();
+	struct runtime_source *rs;
+
+	pthread_mutex_lock(&sources_mutex);
+	for (rs = sources; rs; rs = rs->next) {
+		obs_data_t *entry = obs_data_create();
+		obs_data_set_string(entry, "name",
+			obs_source_get_name(rs->source));
+		motion_stats_save(rs->stats, entry);
+		obs_data_array_push_back(array, entry);
+		obs_data_release(entry);
+	}
+	pthread_mutex_unlock(&sources_mutex);
+
+	obs_data_set_array(json, "sources", array);
+	calldata_set_string(cd, "json", obs_data_get_json(json));
+	obs_data_array_release(array);
+	obs_data_release(json);
+	UNUSED_PARAMETER(data);
+}
+
+void motion_runtime_add_source(obs_source_t *source,
+	struct motion_stats *stats)
+{
+	struct runtime_source *rs = bzalloc(sizeof(*rs));
+
+	rs->source = source;
+	rs->stats = stats;
+	motion_stats_register(source, stats);
+	motion_trace_register(source);
+
+	pthread_mutex_lock(&sources_mutex);
+	rs->next = sources;
+	sources = rs;
+	pthread_mutex_unlock(&sources_mutex);
+}
+
+void motion_runtime_remove_source(struct motion_stats *stats)
+{
+	struct runtime_source **prev = &sources;
+	struct runtime_source *rs = NULL;
+
+	pthread_mutex_lock(&sources_mutex);
+	for (; *prev; prev = &(*prev)->next) {
+		if ((*prev)->stats == stats) {
+			rs = *prev;
+			*prev = rs->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&sources_mutex);
+
+	if (rs && stats->eval_ns.count)
+		motion_stats_log(rs->source, stats);
+	bfree(rs);
+}
+
+void motion_runtime_enum_sources(motion_runtime_enum_func func, void *param)
+{
+	struct runtime_source *rs;
+
+	pthread_mutex_lock(&sources_mutex);
+	for (rs = sources; rs; rs = rs->next)
+		func(param, rs->source);
+	pthread_mutex_unlock(&sources_mutex);
+}
+
+void motion_runtime_add_evaluator(void *data, motion_eval_ready_t ready,
+	motion_eval_t eval)
+{
+	struct runtime_evaluator *ev = bzalloc(sizeof(*ev));
+
+	ev->data = data;
+	ev->ready = ready;
+	ev->eval = eval;
+
+	pthread_mutex_lock(&evaluators_mutex);
+	ev->next = evaluators;
+	evaluators = ev;
+	pthread_mutex_unlock(&evaluators_mutex);
+}
+
+void motion_runtime_remove_evaluator(void *data)
+{
+	struct runtime_evaluator **prev = &evaluators;
+	struct runtime_evaluator *ev = NULL;
+
+	pthread_mutex_lock(&evaluators_mutex);
+	for (; *prev; prev = &(*prev)->next) {
+		if ((*prev)->data == data) {
+			ev = *prev;
+			*prev = ev->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&evaluators_mutex);
+
+	bfree(ev);
+}
+
+void motion_runtime_init(void)
+{
+	if (initialized)
+		return;
+
+	motion_trace_init();
+	thread_pool_init();
+	motion_trigger_init();
+	motion_control_init();
+
+	obs_add_tick_callback(runtime_tick, NULL);
+	proc_handler_add(obs_get_proc_handler(),
+		"void get_motion_effect_stats(out string json)",
+		get_motion_effect_stats, NULL);
+	initialized = true;
+}
+
+void motion_runtime_free(void)
+{
+	if (!initialized)
+		return;
+
+	motion_control_free();
+	obs_remove_tick_callback(runtime_tick, NULL);
+	bfree(in_flight);
+	in_flight = NULL;
+	in_flight_capacity = 0;
+	motion_trigger_free();
+	motion_record_free();
+	thread_pool_free();
+	epoch_free();
+	motion_trace_free();
+	initialized = false;
+}
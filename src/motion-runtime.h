@@ -0,0 +1,65 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#pragma once
+
+#include <obs-module.h>
+#include "motion-stats.h"
+
+/*
+ * Runtime shared by every source type of the module. Tracing, the worker
+ * pool, the trigger queue, the control socket and the recorder are started
+ * once on load and stopped once on unload, and retired objects are
+ * reclaimed every frame.
+ * Motion sources register themselves on creation; one tick callback then
+ * does the housekeeping for all of them each frame, and the global
+ * 'get_motion_effect_stats' proc returns the stats of every live instance
+ * in one call:
+ *
+ *   void get_motion_effect_stats(out string json)
+ *
+ *   {"sources": [{"name": "<source>", "eval_ns": {...}, ...}, ...]}
+ *
+ * Sources that animate from their video tick can also register an
+ * evaluator. When enough of them are in flight, the runtime's tick, which
+ * runs before sources tick, evaluates all of them on the worker pool into
+ * their own staging, and each source's tick then only commits its staged
+ * values, in libobs' usual order.
+ */
+
+/* 'ready' says whether the source has a motion to evaluate this frame */
+typedef bool (*motion_eval_ready_t)(void *data);
+typedef void (*motion_eval_t)(void *data);
+
+void motion_runtime_init(void);
+void motion_runtime_free(void);
+
+void motion_runtime_add_source(obs_source_t *source,
+	struct motion_stats *stats);
+void motion_runtime_remove_source(struct motion_stats *stats);
+
+typedef void (*motion_runtime_enum_func)(void *param, obs_source_t *source);
+
+/* runs with the source list locked, so sources stay alive during the call */
+void motion_runtime_enum_sources(motion_runtime_enum_func func, void *param);
+
+void motion_runtime_add_evaluator(void *data, motion_eval_ready_t ready,
+	motion_eval_t eval);
+void motion_runtime_remove_evaluator(void *data);
@@ -0,0 +1,198 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#include "motion-stats.h"
+#include <util/platform.h>
+#include <util/threading.h>
+
+#ifdef _MSC_VER
+#include <windows.h>
+#endif
+
+#define STATS_LOG_INTERVAL 60000000000ULL
+
+/* keeps the loads before it from moving past the loads after it */
+static inline void acquire_fence(void)
+{
+#ifdef _MSC_VER
+	MemoryBarrier();
+#else
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline int bucket_index(uint64_t value)
+{
+	int idx = 0;
+
+	while (value && idx < STAT_BUCKETS - 1) {
+		value >>= 1;
+		idx++;
+	}
+
+	return idx;
+}
+
+void motion_stat_record(struct motion_stat *stat, uint64_t value)
+{
+	os_atomic_inc_long(&stat->seq);
+
+	if (!stat->count || value < stat->min)
+		stat->min = value;
+	if (value > stat->max)
+		stat->max = value;
+	stat->count++;
+	stat->sum += value;
+	stat->buckets[bucket_index(value)]++;
+
+	os_atomic_inc_long(&stat->seq);
+}
+
+void motion_stat_read(struct motion_stat *stat,
+	struct motion_stat_summary *summary)
+{
+	struct motion_stat copy;
+	uint64_t target, seen = 0;
+	long seq;
+
+	do {
+		seq = os_atomic_load_long(&stat->seq);
+		if (seq & 1)
+			continue;
+		memcpy(&copy, (const void*)stat, sizeof(copy));
+		/* the copy must be complete before 'seq' is checked again */
+		acquire_fence();
+	} while ((seq & 1) || seq != os_atomic_load_long(&stat->seq));
+
+	memset(summary, 0, sizeof(*summary));
+	if (!copy.count)
+		return;
+
+	summary->count = copy.count;
+	summary->min = copy.min;
+	summary->max = copy.max;
+	summary->mean = copy.sum / copy.count;
+
+	/* upper edge of the bucket holding the 99th percentile sample */
+	target = copy.count - copy.count / 100;
+	for (int i = 0; i < STAT_BUCKETS; i++) {
+		seen += copy.buckets[i];
+		if (seen >= target) {
+			summary->p99 = i ? (1ULL << i) - 1 : 0;
+			break;
+		}
+	}
+
+	if (summary->p99 > summary->max)
+		summary->p99 = summary->max;
+}
+
+static void set_stat(obs_data_t *data, const char *name,
+	struct motion_stat *stat)
+{
+	struct motion_stat_summary summary;
+	obs_data_t *obj = obs_data_create();
+
+	motion_stat_read(stat, &summary);
+	obs_data_set_int(obj, "count", (long long)summary.count);
+	obs_data_set_int(obj, "min", (long long)summary.min);
+	obs_data_set_int(obj, "mean", (long long)summary.mean);
+	obs_data_set_int(obj, "p99", (long long)summary.p99);
+	obs_data_set_int(obj, "max", (long long)summary.max);
+	obs_data_set_obj(data, name, obj);
+	obs_data_release(obj);
+}
+
+void motion_stats_save(struct motion_stats *stats, obs_data_t *data)
+{
+	set_stat(data, "eval_ns", &stats->eval_ns);
+	set_stat(data, "commit_ns", &stats->commit_ns);
+	set_stat(data, "items_touched", &stats->items_touched);
+	set_stat(data, "setter_calls", &stats->setter_calls);
+	set_stat(data, "plan_ns", &stats->plan_ns);
+	set_stat(data, "duplicate_ns", &stats->duplicate_ns);
+}
+
+static void get_motion_stats(void *data, calldata_t *cd)
+{
+	struct motion_stats *stats = data;
+	obs_data_t *json = obs_data_create();
+
+	motion_stats_save(stats, json);
+	calldata_set_string(cd, "json", obs_data_get_json(json));
+	obs_data_release(json);
+}
+
+void motion_stats_register(obs_source_t *source, struct motion_stats *stats)
+{
+	proc_handler_t *ph = obs_source_get_proc_handler(source);
+	proc_handler_add(ph, "void get_motion_stats(out string json)",
+		get_motion_stats, stats);
+}
+
+static void log_stat(const char *name, struct motion_stat *stat,
+	double unit)
+{
+	struct motion_stat_summary s;
+
+	motion_stat_read(stat, &s);
+	if (!s.count)
+		return;
+
+	blog(LOG_INFO, "[motion-effect]   %-14s n=%llu min=%.3f mean=%.3f "
+		"p99=%.3f max=%.3f", name, (unsigned long long)s.count,
+		s.min / unit, s.mean / unit, s.p99 / unit, s.max / unit);
+}
+
+void motion_stats_log(obs_source_t *source, struct motion_stats *stats)
+{
+	blog(LOG_INFO, "[motion-effect] stats for '%s' (times in ms):",
+		obs_source_get_name(source));
+	log_stat("evaluate", &stats->eval_ns, 1000000.0);
+	log_stat("commit", &stats->commit_ns, 1000000.0);
+	log_stat("items touched", &stats->items_touched, 1.0);
+	log_stat("setter calls", &stats->setter_calls, 1.0);
+	log_stat("plan build", &stats->plan_ns, 1000000.0);
+	log_stat("scene dup", &stats->duplicate_ns, 1000000.0);
+}
+
+/*
+ * Logs a summary at most once a minute, and only if the instance did
+ * some work since the last one, so idle instances stay out of the log.
+ */
+void motion_stats_tick(obs_source_t *source, struct motion_stats *stats)
+{
+	uint64_t now = os_gettime_ns();
+
+	if (!stats->last_log_ns) {
+		stats->last_log_ns = now;
+		return;
+	}
+
+	if (now - stats->last_log_ns < STATS_LOG_INTERVAL)
+		return;
+
+	stats->last_log_ns = now;
+	if (stats->eval_ns.count == stats->last_log_count)
+		return;
+
+	stats->last_log_count = stats->eval_ns.count;
+	motion_stats_log(source, stats);
+}
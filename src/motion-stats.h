@@ -0,0 +1,68 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#pragma once
+
+#include <obs-module.h>
+
+#define STAT_BUCKETS 48
+
+/*
+ * A single value series with a log2 histogram. Each series has one writer
+ * (the thread that ticks or renders its instance); readers on other
+ * threads take consistent copies through a sequence counter, so neither
+ * side ever blocks.
+ */
+struct motion_stat {
+	volatile long       seq;
+	uint64_t            count;
+	uint64_t            sum;
+	uint64_t            min;
+	uint64_t            max;
+	uint32_t            buckets[STAT_BUCKETS];
+};
+
+struct motion_stat_summary {
+	uint64_t            count;
+	uint64_t            min;
+	uint64_t            mean;
+	uint64_t            p99;
+	uint64_t            max;
+};
+
+struct motion_stats {
+	struct motion_stat  eval_ns;
+	struct motion_stat  commit_ns;
+	struct motion_stat  items_touched;
+	struct motion_stat  setter_calls;
+	struct motion_stat  plan_ns;
+	struct motion_stat  duplicate_ns;
+	uint64_t            last_log_ns;
+	uint64_t            last_log_count;
+};
+
+void motion_stat_record(struct motion_stat *stat, uint64_t value);
+void motion_stat_read(struct motion_stat *stat,
+	struct motion_stat_summary *summary);
+
+void motion_stats_save(struct motion_stats *stats, obs_data_t *data);
+void motion_stats_register(obs_source_t *source, struct motion_stats *stats);
+void motion_stats_tick(obs_source_t *source, struct motion_stats *stats);
+void motion_stats_log(obs_source_t *source, struct motion_stats *stats);
@@ -0,0 +1,277 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#include "motion-trace.h"
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define TRACE_ENV          "MOTION_EFFECT_TRACE"
+#define TRACE_EVENTS       (1 << 15)
+#define TRACE_NAME_LEN     32
+#define TRACE_DUMP_SPACING 5000000000ULL
+
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+struct trace_event {
+	volatile long       seq;
+	const char          *name;
+	uint64_t            ts;
+	uint64_t            dur;
+	long                tid;
+	char                phase;
+	char                source[TRACE_NAME_LEN];
+};
+
+bool motion_trace_active = false;
+
+static struct trace_event *events;
+static volatile long next_event;
+static volatile long next_tid;
+static uint64_t base_ns;
+static uint64_t slow_frame_ns;
+static uint64_t last_dump_ns;
+
+static pthread_t dump_thread;
+static os_event_t *dump_event;
+static volatile bool dump_pending;
+static volatile bool stopping;
+
+static THREAD_LOCAL long thread_id;
+
+static inline long get_thread_id(void)
+{
+	if (!thread_id)
+		thread_id = os_atomic_inc_long(&next_tid);
+	return thread_id;
+}
+
+static void record(const char *name, obs_source_t *source, char phase,
+	uint64_t start_ns, uint64_t end_ns)
+{
+	long idx = os_atomic_inc_long(&next_event) - 1;
+	struct trace_event *ev = &events[(unsigned long)idx & (TRACE_EVENTS - 1)];
+	const char *source_name = source ? obs_source_get_name(source) : NULL;
+
+	os_atomic_set_long(&ev->seq, 0);
+	ev->name = name;
+	ev->ts = start_ns;
+	ev->dur = end_ns - start_ns;
+	ev->tid = get_thread_id();
+	ev->phase = phase;
+	if (source_name) {
+		strncpy(ev->source, source_name, TRACE_NAME_LEN - 1);
+		ev->source[TRACE_NAME_LEN - 1] = 0;
+	} else {
+		ev->source[0] = 0;
+	}
+	os_atomic_set_long(&ev->seq, idx + 1);
+}
+
+void motion_trace_event(const char *name, obs_source_t *source,
+	uint64_t start_ns, uint64_t end_ns)
+{
+	if (motion_trace_active)
+		record(name, source, 'X', start_ns, end_ns);
+}
+
+void motion_trace_instant(const char *name, obs_source_t *source)
+{
+	if (motion_trace_active) {
+		uint64_t now = os_gettime_ns();
+		record(name, source, 'i', now, now);
+	}
+}
+
+void motion_trace_frame(uint64_t frame_ns)
+{
+	if (!motion_trace_active || !slow_frame_ns || frame_ns < slow_frame_ns)
+		return;
+
+	motion_trace_instant("slow frame", NULL);
+	if (!os_atomic_set_bool(&dump_pending, true))
+		os_event_signal(dump_event);
+}
+
+static void append_escaped(struct dstr *json, const char *str)
+{
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			dstr_cat_ch(json, '\\');
+		if ((unsigned char)*str >= 0x20)
+			dstr_cat_ch(json, *str);
+	}
+}
+
+char *motion_trace_dump(void)
+{
+	long end = os_atomic_load_long(&next_event);
+	long start = end > TRACE_EVENTS ? end - TRACE_EVENTS : 0;
+	struct dstr json = { 0 };
+	struct dstr file = { 0 };
+	char *dir, *path;
+	bool first = true;
+
+	if (!motion_trace_active)
+		return NULL;
+
+	dstr_copy(&json, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+	for (long idx = start; idx < end; idx++) {
+		struct trace_event *slot = &events[(unsigned long)idx &
+			(TRACE_EVENTS - 1)];
+		struct trace_event ev = *slot;
+
+		/* skip slots that were being rewritten while copied */
+		if (ev.seq != idx + 1 || os_atomic_load_long(&slot->seq) != ev.seq)
+			continue;
+
+		dstr_catf(&json, "%s{\"name\":\"%s\",\"cat\":\"motion\","
+			"\"ph\":\"%c\",\"ts\":%.3f,", first ? "" : ",",
+			ev.name, ev.phase, (ev.ts - base_ns) / 1000.0);
+		if (ev.phase == 'X')
+			dstr_catf(&json, "\"dur\":%.3f,", ev.dur / 1000.0);
+		else
+			dstr_cat(&json, "\"s\":\"t\",");
+		dstr_catf(&json, "\"pid\":1,\"tid\":%ld,\"args\":{\"source\":\"",
+			ev.tid);
+		append_escaped(&json, ev.source);
+		dstr_cat(&json, "\"}}");
+		first = false;
+	}
+
+	dstr_cat(&json, "]}\n");
+
+	dir = obs_module_config_path("");
+	if (dir) {
+		os_mkdirs(dir);
+		bfree(dir);
+	}
+
+	dstr_printf(&file, "motion-trace-%llu.json",
+		(unsigned long long)(os_gettime_ns() / 1000000));
+	path = obs_module_config_path(file.array);
+
+	if (path && !os_quick_write_utf8_file(path, json.array, json.len,
+			false)) {
+		blog(LOG_WARNING, "[motion-effect] failed to write trace '%s'",
+			path);
+		bfree(path);
+		path = NULL;
+	} else if (path) {
+		blog(LOG_INFO, "[motion-effect] trace written to '%s'", path);
+	}
+
+	dstr_free(&file);
+	dstr_free(&json);
+	return path;
+}
+
+static void *dump_thread_func(void *data)
+{
+	UNUSED_PARAMETER(data);
+	os_set_thread_name("motion-effect: trace dump");
+
+	while (os_event_wait(dump_event) == 0) {
+		uint64_t now;
+
+		if (os_atomic_load_bool(&stopping))
+			break;
+
+		now = os_gettime_ns();
+		if (!last_dump_ns || now - last_dump_ns >= TRACE_DUMP_SPACING) {
+			bfree(motion_trace_dump());
+			last_dump_ns = now;
+		}
+		os_atomic_set_bool(&dump_pending, false);
+	}
+
+	return NULL;
+}
+
+static void dump_motion_trace(void *data, calldata_t *cd)
+{
+	char *path = motion_trace_dump();
+	calldata_set_string(cd, "path", path ? path : "");
+	bfree(path);
+	UNUSED_PARAMETER(data);
+}
+
+void motion_trace_register(obs_source_t *source)
+{
+	proc_handler_t *ph;
+
+	if (!motion_trace_active)
+		return;
+
+	ph = obs_source_get_proc_handler(source);
+	proc_handler_add(ph, "void dump_motion_trace(out string path)",
+		dump_motion_trace, NULL);
+}
+
+void motion_trace_init(void)
+{
+	const char *env = getenv(TRACE_ENV);
+
+	if (!env || motion_trace_active)
+		return;
+
+	events = bzalloc(sizeof(struct trace_event) * TRACE_EVENTS);
+	slow_frame_ns = (uint64_t)(atof(env) * 1000000.0);
+	base_ns = os_gettime_ns();
+
+	if (os_event_init(&dump_event, OS_EVENT_TYPE_AUTO) != 0) {
+		dump_event = NULL;
+	} else if (pthread_create(&dump_thread, NULL, dump_thread_func,
+			NULL) != 0) {
+		os_event_destroy(dump_event);
+		dump_event = NULL;
+	}
+
+	if (!dump_event)
+		slow_frame_ns = 0;
+
+	motion_trace_active = true;
+	blog(LOG_INFO, "[motion-effect] tracing enabled, slow frame "
+		"threshold %.2f ms", slow_frame_ns / 1000000.0);
+}
+
+void motion_trace_free(void)
+{
+	if (!motion_trace_active)
+		return;
+
+	motion_trace_active = false;
+
+	if (dump_event) {
+		os_atomic_set_bool(&stopping, true);
+		os_event_signal(dump_event);
+		pthread_join(dump_thread, NULL);
+		os_event_destroy(dump_event);
+		dump_event = NULL;
+	}
+
+	bfree(events);
+	events = NULL;
+}
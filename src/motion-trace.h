@@ -0,0 +1,46 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#pragma once
+
+#include <obs-module.h>
+
+/*
+ * Opt-in event tracer. Set MOTION_EFFECT_TRACE before starting OBS to
+ * enable it; a numeric value is used as a slow-frame threshold in ms, and
+ * any frame over it triggers a dump. Events go to a preallocated ring
+ * buffer and are written as Chrome Trace Event JSON (chrome://tracing,
+ * Perfetto) to the plugin config directory, either on a slow frame or on
+ * demand through the 'dump_motion_trace' proc of any motion source.
+ */
+
+extern bool motion_trace_active;
+
+void motion_trace_init(void);
+void motion_trace_free(void);
+
+void motion_trace_register(obs_source_t *source);
+
+void motion_trace_event(const char *name, obs_source_t *source,
+	uint64_t start_ns, uint64_t end_ns);
+void motion_trace_instant(const char *name, obs_source_t *source);
+void motion_trace_frame(uint64_t frame_ns);
+
+char *motion_trace_dump(void);
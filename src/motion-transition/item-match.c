@@ -0,0 +1,248 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+#include "item-match.h"
+#include <math.h>
+
+/*
+ * Above this many instances of one source on either side the optimal
+ * assignment is replaced by a greedy one, so setup stays bounded.
+ */
+#define MATCH_OPTIMAL_MAX 64
+
+struct match_run {
+	list_info_t        *rows;
+	list_info_t        *cols;
+	const name_index_t *row_index;
+	const name_index_t *col_index;
+	size_t             num_rows;
+	size_t             num_cols;
+};
+
+static inline float travel(const item_snapshot_t *a, const item_snapshot_t *b)
+{
+	return hypotf(a->info.pos.x - b->info.pos.x,
+		a->info.pos.y - b->info.pos.y);
+}
+
+static inline void set_match(struct match_run *run, size_t row, size_t col)
+{
+	size_t row_idx = run->row_index[row].idx;
+	size_t col_idx = run->col_index[col].idx;
+
+	run->rows->match[row_idx] = col_idx;
+	run->cols->match[col_idx] = row_idx;
+}
+
+static inline float run_cost(struct match_run *run, size_t row, size_t col)
+{
+	return travel(&run->rows->snapshots[run->row_index[row].idx],
+		&run->cols->snapshots[run->col_index[col].idx]);
+}
+
+/*
+ * Hungarian method with row and column potentials, O(rows^2 * cols). Rows
+ * are the smaller side, so every row gets a column.
+ */
+static void match_optimal(struct arena *arena, struct match_run *run)
+{
+	size_t n = run->num_rows;
+	size_t m = run->num_cols;
+	float *cost = arena_alloc(arena, sizeof(float) * n * m);
+	double *u = arena_alloc(arena, sizeof(double) * (n + 1));
+	double *v = arena_alloc(arena, sizeof(double) * (m + 1));
+	double *min_v = arena_alloc(arena, sizeof(double) * (m + 1));
+	size_t *p = arena_alloc(arena, sizeof(size_t) * (m + 1));
+	size_t *way = arena_alloc(arena, sizeof(size_t) * (m + 1));
+	bool *used = arena_alloc(arena, sizeof(bool) * (m + 1));
+
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = 0; j < m; j++)
+			cost[i * m + j] = run_cost(run, i, j);
+	}
+
+	for (size_t i = 1; i <= n; i++) {
+		size_t j0 = 0;
+
+		p[0] = i;
+		for (size_t j = 0; j <= m; j++) {
+			min_v[j] = HUGE_VAL;
+			used[j] = false;
+		}
+
+		do {
+			size_t i0 = p[j0], j1 = 0;
+			double delta = HUGE_VAL;
+
+			used[j0] = true;
+			for (size_t j = 1; j <= m; j++) {
+				double cur;
+
+				if (used[j])
+					continue;
+
+				cur = cost[(i0 - 1) * m + j - 1] - u[i0] - v[j];
+				if (cur < min_v[j]) {
+					min_v[j] = cur;
+					way[j] = j0;
+				}
+				if (min_v[j] < delta) {
+					delta = min_v[j];
+					j1 = j;
+				}
+			}
+
+			for (size_t j = 0; j <= m; j++) {
+				if (used[j]) {
+					u[p[j]] += delta;
+					v[j] -= delta;
+				} else {
+					min_v[j] -= delta;
+				}
+			}
+
+			j0 = j1;
+		} while (p[j0] != 0);
+
+		do {
+			size_t j1 = way[j0];
+			p[j0] = p[j1];
+			j0 = j1;
+		} while (j0);
+	}
+
+	for (size_t j = 1; j <= m; j++) {
+		if (p[j])
+			set_match(run, p[j] - 1, j - 1);
+	}
+}
+
+/* each row in z-order takes the nearest column still free, O(rows * cols) */
+static void match_greedy(struct arena *arena, struct match_run *run)
+{
+	bool *taken = arena_alloc(arena, sizeof(bool) * run->num_cols);
+
+	for (size_t i = 0; i < run->num_rows; i++) {
+		size_t best = MATCH_NONE;
+		float best_cost = 0.0f;
+
+		for (size_t j = 0; j < run->num_cols; j++) {
+			float cur;
+
+			if (taken[j])
+				continue;
+
+			cur = run_cost(run, i, j);
+			if (best == MATCH_NONE || cur < best_cost) {
+				best = j;
+				best_cost = cur;
+			}
+		}
+
+		taken[best] = true;
+		set_match(run, i, best);
+	}
+}
+
+static void match_run(struct arena *arena, list_info_t *out_list,
+	const name_index_t *out_index, size_t num_out, list_info_t *in_list,
+	const name_index_t *in_index, size_t num_in)
+{
+	struct match_run run;
+
+	if (num_out == 1 && num_in == 1) {
+		out_list->match[out_index->idx] = in_index->idx;
+		in_list->match[in_index->idx] = out_index->idx;
+		return;
+	}
+
+	if (num_out <= num_in) {
+		run.rows = out_list;
+		run.row_index = out_index;
+		run.num_rows = num_out;
+		run.cols = in_list;
+		run.col_index = in_index;
+		run.num_cols = num_in;
+	} else {
+		run.rows = in_list;
+		run.row_index = in_index;
+		run.num_rows = num_in;
+		run.cols = out_list;
+		run.col_index = out_index;
+		run.num_cols = num_out;
+	}
+
+	if (run.num_cols <= MATCH_OPTIMAL_MAX)
+		match_optimal(arena, &run);
+	else
+		match_greedy(arena, &run);
+}
+
+static inline int compare_names(const char *a, const char *b)
+{
+	return strcmp(a ? a : "", b ? b : "");
+}
+
+/*
+ * Both name indexes are sorted by name, then z-order, so the instances of
+ * each source form one run on either side and a single merge walk finds
+ * them all.
+ */
+void match_items(transition_plan_t *plan)
+{
+	list_info_t *out_list = &plan->out_list;
+	list_info_t *in_list = &plan->in_list;
+	size_t num_out = out_list->num_snapshots;
+	size_t num_in = in_list->num_snapshots;
+	size_t i = 0, j = 0;
+
+	out_list->match = arena_alloc(&plan->arena, sizeof(size_t) *
+		(num_out + num_in));
+	in_list->match = out_list->match + num_out;
+	for (size_t k = 0; k < num_out + num_in; k++)
+		out_list->match[k] = MATCH_NONE;
+
+	while (i < num_out && j < num_in) {
+		const char *name = out_list->index[i].name;
+		int cmp = compare_names(name, in_list->index[j].name);
+		size_t end_i = i, end_j = j;
+
+		if (cmp < 0 || !name) {
+			i++;
+			continue;
+		} else if (cmp > 0) {
+			j++;
+			continue;
+		}
+
+		while (end_i < num_out && compare_names(
+				out_list->index[end_i].name, name) == 0)
+			end_i++;
+		while (end_j < num_in && compare_names(
+				in_list->index[end_j].name, name) == 0)
+			end_j++;
+
+		match_run(&plan->arena, out_list, &out_list->index[i],
+			end_i - i, in_list, &in_list->index[j], end_j - j);
+		i = end_i;
+		j = end_j;
+	}
+}
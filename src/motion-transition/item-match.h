@@ -0,0 +1,34 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+#pragma once
+
+#include "transition-plan.h"
+
+#define MATCH_NONE ((size_t)-1)
+
+/*
+ * Pairs the items of the two scenes. Items are grouped by source through
+ * the name indexes; a source that appears once on each side is a direct
+ * pair, repeated instances are assigned so the total travel distance is
+ * as small as possible. Fills the match array of both lists.
+ */
+void match_items(transition_plan_t *plan);
@@ -19,232 +19,561 @@
 
 
 #include "obs-module.h"
-#include "../helper.h"
+#include "transition-plan.h"
+#include "../motion-runtime.h"
+#include "../epoch.h"
+#include "../motion-trace.h"
 #include <obs-scene.h>
+#include <util/platform.h>
+#include <math.h>
 
-enum variation_type {
-	VARIATION_MOTION = 0,
-	VARIATION_ZOOMOUT = 1,
-	VARIATION_ZOOMIN = 2
+enum render_mode {
+	RENDER_DUPLICATE = 0,
+	RENDER_DIRECT = 1
 };
 
+enum audio_fade {
+	FADE_LINEAR = 0,
+	FADE_EQUAL_POWER = 1,
+	FADE_MOTION = 2
+};
 
 #define S_BEZIER_X        "bezier_x"
 #define S_BEZIER_Y        "bezier_y"
+#define S_GOVERNOR        "governor"
+#define S_FRAME_BUDGET    "frame_budget"
+#define S_LAG_FRAMES      "lag_frames"
+#define S_SMALL_AREA      "small_item_area"
+#define S_RENDER_MODE     "render_mode"
+#define S_STAGGER         "stagger"
+#define S_STAGGER_AMOUNT  "stagger_amount"
+#define S_STAGGER_REVERSE "stagger_reverse"
+#define S_FOCAL_X         "stagger_focal_x"
+#define S_FOCAL_Y         "stagger_focal_y"
+#define S_AUDIO_FADE      "audio_fade"
 
 #define T_(v)             obs_module_text(v)
 #define T_BEZIER_X        T_("Acceleration.X")
 #define T_BEZIER_Y        T_("Acceleration.Y")
-
-
-typedef struct moving_item moving_item_t;
-typedef struct list_info list_info_t;
+#define T_GOVERNOR        T_("Governor")
+#define T_FRAME_BUDGET    T_("Governor.FrameBudget")
+#define T_LAG_FRAMES      T_("Governor.LagFrames")
+#define T_SMALL_AREA      T_("Governor.SmallItemArea")
+#define T_RENDER_MODE     T_("RenderMode")
+#define T_RENDER_DUP      T_("RenderMode.Duplicate")
+#define T_RENDER_DIRECT   T_("RenderMode.Direct")
+#define T_STAGGER         T_("Stagger")
+#define T_STAGGER_NONE    T_("Stagger.None")
+#define T_STAGGER_Z_ORDER T_("Stagger.ZOrder")
+#define T_STAGGER_DIST    T_("Stagger.Distance")
+#define T_STAGGER_TYPE    T_("Stagger.SourceType")
+#define T_STAGGER_AMOUNT  T_("Stagger.Amount")
+#define T_STAGGER_REVERSE T_("Stagger.Reverse")
+#define T_FOCAL_X         T_("Stagger.FocalX")
+#define T_FOCAL_Y         T_("Stagger.FocalY")
+#define T_AUDIO_FADE      T_("AudioFade")
+#define T_FADE_LINEAR     T_("AudioFade.Linear")
+#define T_FADE_EQUAL      T_("AudioFade.EqualPower")
+#define T_FADE_MOTION     T_("AudioFade.Motion")
+
+#define GOVERNOR_ESCALATE 3
+#define GOVERNOR_RECOVER  60
+#define GAIN_STEPS        256
+
+
+typedef struct governor governor_t;
 typedef struct transition_data transition_data_t;
 
-struct moving_item {
-	obs_sceneitem_t           *item;
-	enum variation_type       type;
-	struct obs_transform_info start_info;
-	struct obs_transform_info end_info;
-	struct obs_sceneitem_crop start_crop;
-	struct obs_sceneitem_crop end_crop;
-	struct vec2               control_pos;
-	moving_item_t             *next;
+/*
+ * Watches plugin render cost and OBS frame lag, and steps the animation
+ * quality down one tier at a time while the system is overloaded. The
+ * cost includes rendering both scenes, which heavy scenes exceed on their
+ * own, so it is off unless enabled.
+ */
+struct governor {
+	bool                enabled;
+	uint64_t            budget_ns;
+	uint32_t            lag_threshold;
+	enum governor_tier  tier;
+	uint32_t            frame;
+	uint32_t            over_budget;
+	uint32_t            calm_frames;
+	uint32_t            lagged;
+	uint32_t            new_lag;
 };
 
-struct list_info {
-	obs_scene_t        *scene;
-	obs_source_t       *source;
-	moving_item_t      *last_item;
-	moving_item_t      *first_item;
+/* tabulated crossfade curves, for the fades that are not linear */
+struct gain_ramps {
+	float               a[GAIN_STEPS + 1];
+	float               b[GAIN_STEPS + 1];
 };
 
+/*
+ * The plan of the running transition is published through 'plan': render,
+ * audio and enum callbacks read it inside an epoch section, and stop or
+ * the next start swap it out and retire the old one, which is freed only
+ * after every reader has left. 'ramps' is published and retired the same
+ * way by update, and is NULL for the linear fade.
+ */
 struct transition_data {
 	obs_source_t        *context;
-	list_info_t         out_list;
-	list_info_t         in_list;
+	transition_plan_t   *volatile plan;
+	struct motion_stats stats;
+	governor_t          governor;
+	enum render_mode    render_mode;
 	float               acc_x;
 	float               acc_y;
+	float               small_area;
+	enum stagger_mode   stagger;
+	float               stagger_amount;
+	struct vec2         focal;
+	bool                stagger_reverse;
+	enum audio_fade     audio_fade;
+	struct gain_ramps   *volatile ramps;
+	float               shown_time;
 	bool                start_init;
-	bool                scene_transition;
-	bool                transitioning;
 };
 
-static bool append_item_list(obs_scene_t *scene, obs_sceneitem_t *item_a, void *data)
+/*
+ * One animated frame: evaluate every item into staging, then commit in
+ * z-order, either as setter calls on the duplicated scene or as direct
+ * draws of the original sources.
+ */
+static void render_frame(transition_data_t *tr, transition_plan_t *plan,
+	list_info_t *list, float t)
 {
-	transition_data_t *tr = data;
-	bool transition_out = tr->out_list.scene == scene;
-	bool transform_variation = false;
-	list_info_t *list, *list_cmp;
-	struct obs_transform_info *info_a, *info_b;
-	struct obs_sceneitem_crop *crop_a, *crop_b;
-	obs_source_t *source_a = obs_sceneitem_get_source(item_a);
-	obs_sceneitem_t *item_b;
-	moving_item_t *next = bzalloc(sizeof(*next));
-
-	if (transition_out) {
-		list = &tr->out_list;
-		list_cmp = &tr->in_list;
-		info_a = &next->start_info;
-		info_b = &next->end_info;
-		crop_a = &next->start_crop;
-		crop_b = &next->end_crop;
-	} else {
-		list = &tr->in_list;
-		list_cmp = &tr->out_list;
-		info_a = &next->end_info;
-		info_b = &next->start_info;
-		crop_a = &next->end_crop;
-		crop_b = &next->start_crop;
-	}
+	uint64_t touched = 0;
+	uint64_t setters = 0;
+	uint64_t start = os_gettime_ns();
+	uint64_t eval_end, commit_end;
 
-	obs_sceneitem_get_info(item_a, info_a);
-	obs_sceneitem_get_crop(item_a, crop_a);
-	item_b = obs_scene_find_source(list_cmp->scene, 
-		obs_source_get_name(source_a));
+	evaluate_items(plan, list, t, tr->governor.tier, tr->governor.frame);
+	eval_end = os_gettime_ns();
 
-
-	if (item_b) {
-		obs_sceneitem_get_info(item_b, info_b);
-		obs_sceneitem_get_crop(item_b, crop_b);
-		transform_variation = same_transform_type(info_a, info_b);
-	}
-
-	if (transform_variation) {
-		float t = transition_out ? tr->acc_x : 1 - tr->acc_x;
-		float f = transition_out ? tr->acc_y : 1 - tr->acc_y;
-		next->control_pos.x = (1 - t) * info_a->pos.x + t * info_b->pos.x;
-		next->control_pos.y = (1 - f) * info_a->pos.y + f * info_b->pos.y;
-		next->type = VARIATION_MOTION;
+	if (plan->direct_render) {
+		render_items(plan, list, &touched);
 	} else {
-		float w = obs_source_get_base_width(source_a) * info_a->scale.x;
-		float h = obs_source_get_base_height(source_a) * info_a->scale.y;
-		info_b->pos.x = info_a->pos.x + w / 2;
-		info_b->pos.y = info_a->pos.y + h / 2;
-		info_b->scale.x = 0;
-		info_b->scale.y = 0;
-		next->type = transition_out ? VARIATION_ZOOMOUT : VARIATION_ZOOMIN;
+		commit_items(plan, list, tr->governor.tier, &touched, &setters);
+		obs_source_video_render(list->source);
 	}
+	commit_end = os_gettime_ns();
+
+	motion_trace_event("evaluate", tr->context, start, eval_end);
+	motion_trace_event("commit", tr->context, eval_end, commit_end);
+	motion_stat_record(&tr->stats.eval_ns, eval_end - start);
+	motion_stat_record(&tr->stats.commit_ns, commit_end - eval_end);
+	motion_stat_record(&tr->stats.items_touched, touched);
+	motion_stat_record(&tr->stats.setter_calls, setters);
+}
 
-	next->item = item_a;
+static uint32_t get_lagged_frames(void)
+{
+	return obs_get_lagged_frames() +
+		video_output_get_skipped_frames(obs_get_video());
+}
 
-	if (list->last_item)
-		list->last_item->next = next;
-	else
-		list->first_item = next;
+static void set_governor_tier(transition_data_t *tr, enum governor_tier tier,
+	uint64_t cost_ns)
+{
+	governor_t *gov = &tr->governor;
 
-	list->last_item = next;
+	blog(LOG_INFO, "[motion-transition] '%s': quality tier %d -> %d "
+		"(frame cost %.2f ms, %u lagged frame(s))",
+		obs_source_get_name(tr->context), gov->tier, tier,
+		cost_ns / 1000000.0, gov->new_lag);
 
-	return true;
+	gov->tier = tier;
+	gov->over_budget = 0;
+	gov->calm_frames = 0;
+	gov->new_lag = 0;
 }
 
-static void create_item_list(transition_data_t* tr)
+/*
+ * Each transition starts at full quality. Recovery only counts rendered
+ * frames, so a tier kept from an overloaded transition would otherwise
+ * degrade the next few short ones on an idle system.
+ */
+static void governor_reset(transition_data_t *tr)
 {
-	obs_scene_enum_items(tr->out_list.scene, append_item_list, tr);
-	obs_scene_enum_items(tr->in_list.scene, append_item_list, tr);
+	governor_t *gov = &tr->governor;
+
+	if (gov->tier != TIER_FULL)
+		blog(LOG_INFO, "[motion-transition] '%s': quality tier %d -> "
+			"%d (new transition)", obs_source_get_name(tr->context),
+			gov->tier, TIER_FULL);
+
+	gov->tier = TIER_FULL;
+	gov->over_budget = 0;
+	gov->calm_frames = 0;
+	gov->lagged = get_lagged_frames();
+	gov->new_lag = 0;
 }
 
-static void release_item_list(list_info_t *list)
+/*
+ * Called once per rendered transition frame. Sustained over-budget frames
+ * or fresh OBS lag move one tier down; a long calm stretch moves one up.
+ */
+static void governor_update(transition_data_t *tr, uint64_t cost_ns)
 {
-	moving_item_t *mv = list->first_item;
-	moving_item_t *next;
-	while (mv) {
-		next = mv->next;
-		bfree(mv);
-		mv = next;
+	governor_t *gov = &tr->governor;
+	uint32_t lagged = get_lagged_frames();
+	uint32_t lag = lagged - gov->lagged;
+	bool over;
+
+	gov->frame++;
+	gov->lagged = lagged;
+	gov->new_lag += lag;
+
+	if (!gov->enabled) {
+		if (gov->tier != TIER_FULL)
+			set_governor_tier(tr, TIER_FULL, cost_ns);
+		return;
 	}
 
-	memset(list, 0, sizeof(list_info_t));
+	over = gov->tier != TIER_DIRECT && cost_ns > gov->budget_ns;
+	gov->over_budget = over ? gov->over_budget + 1 : 0;
+
+	if (gov->tier < TIER_DIRECT && (gov->over_budget >= GOVERNOR_ESCALATE ||
+			gov->new_lag >= gov->lag_threshold)) {
+		set_governor_tier(tr, gov->tier + 1, cost_ns);
+		return;
+	}
+
+	if (over || lag) {
+		gov->calm_frames = 0;
+		return;
+	}
+
+	if (++gov->calm_frames < GOVERNOR_RECOVER)
+		return;
+
+	if (gov->tier > TIER_FULL) {
+		set_governor_tier(tr, gov->tier - 1, cost_ns);
+	} else {
+		gov->calm_frames = 0;
+		gov->new_lag = 0;
+	}
 }
 
-static void update_item_information(moving_item_t *mv, float time)
+/*
+ * libobs asks for a gain per sample, per channel and per mixer, so the
+ * curved fades are tabulated once and looked up with a linear
+ * interpolation; the linear fade needs no table. The motion curve follows
+ * the horizontal easing of moving items. A new table is built aside and
+ * swapped in whole, so the audio thread never reads one half-written.
+ */
+static void build_gain_ramps(transition_data_t *tr)
 {
-	struct vec2 pos;
-	struct vec2 scale;
-	struct vec2 bounds;
-	struct obs_sceneitem_crop crop;
-	float rot;
-	float t;
-
-	while(mv) {
-
-		if (mv->type == VARIATION_MOTION) {
-			t = time;
-			vec_bezier(mv->start_info.pos, mv->control_pos, mv->end_info.pos, 
-				&pos, t);
-			vec_linear(mv->start_info.bounds, mv->end_info.bounds, &bounds, t);
-			crop_linear(mv->start_crop, mv->end_crop, &crop, t);
-			rot = (1.0f - t) * mv->start_info.rot + t * mv->end_info.rot;
-			obs_sceneitem_set_bounds(mv->item, &bounds);
-			obs_sceneitem_set_crop(mv->item, &crop);
-			obs_sceneitem_set_rot(mv->item, rot);
-
-		} else if (mv->type == VARIATION_ZOOMIN) {
-			t = time * 2 - 1.0f;
-			vec_linear(mv->start_info.pos, mv->end_info.pos, &pos, t);
-		} else {
-			t = time * 2;
-			vec_linear(mv->start_info.pos, mv->end_info.pos, &pos, t);
+	struct gain_ramps *ramps = NULL;
+	struct gain_ramps *old;
+
+	if (tr->audio_fade == FADE_EQUAL_POWER ||
+			tr->audio_fade == FADE_MOTION)
+		ramps = bmalloc(sizeof(*ramps));
+
+	for (int i = 0; ramps && i <= GAIN_STEPS; i++) {
+		float t = (float)i / GAIN_STEPS;
+		float b;
+
+		if (tr->audio_fade == FADE_EQUAL_POWER) {
+			ramps->a[i] = cosf(t * (float)M_PI * 0.5f);
+			ramps->b[i] = sinf(t * (float)M_PI * 0.5f);
+			continue;
 		}
-		
-		vec_linear(mv->start_info.scale, mv->end_info.scale, &scale, t);
 
-		obs_sceneitem_set_pos(mv->item, &pos);
-		obs_sceneitem_set_scale(mv->item, &scale);	
-		mv = mv->next;
+		b = 2.0f * t * (1.0f - t) * tr->acc_x + t * t;
+		ramps->a[i] = 1.0f - b;
+		ramps->b[i] = b;
 	}
+
+	old = epoch_exchange((void *volatile *)&tr->ramps, ramps);
+	if (old)
+		epoch_retire(old, bfree);
 }
 
 static void motion_transition_update(void *data, obs_data_t *settings)
 {
 	transition_data_t *tr = data;
+	governor_t *gov = &tr->governor;
 	float x = (float)obs_data_get_double(settings, S_BEZIER_X);
 	float y = (float)obs_data_get_double(settings, S_BEZIER_Y);
 	
 	tr->acc_x = - x + 0.5f;
 	tr->acc_y = - y + 0.5f;
+
+	gov->enabled = obs_data_get_bool(settings, S_GOVERNOR);
+	gov->budget_ns = (uint64_t)(obs_data_get_double(settings,
+		S_FRAME_BUDGET) * 1000000.0);
+	gov->lag_threshold = (uint32_t)obs_data_get_int(settings, S_LAG_FRAMES);
+	tr->small_area = (float)obs_data_get_int(settings, S_SMALL_AREA);
+
+	tr->render_mode = (enum render_mode)obs_data_get_int(settings,
+		S_RENDER_MODE);
+
+	tr->stagger = (enum stagger_mode)obs_data_get_int(settings, S_STAGGER);
+	tr->stagger_amount = (float)obs_data_get_double(settings,
+		S_STAGGER_AMOUNT);
+	tr->stagger_reverse = obs_data_get_bool(settings, S_STAGGER_REVERSE);
+	tr->focal.x = (float)obs_data_get_double(settings, S_FOCAL_X);
+	tr->focal.y = (float)obs_data_get_double(settings, S_FOCAL_Y);
+
+	tr->audio_fade = (enum audio_fade)obs_data_get_int(settings,
+		S_AUDIO_FADE);
+	build_gain_ramps(tr);
+}
+
+static void motion_transition_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_int(settings, S_RENDER_MODE, RENDER_DUPLICATE);
+	obs_data_set_default_bool(settings, S_GOVERNOR, false);
+	obs_data_set_default_double(settings, S_FRAME_BUDGET, 4.0);
+	obs_data_set_default_int(settings, S_LAG_FRAMES, 2);
+	obs_data_set_default_int(settings, S_SMALL_AREA, 16384);
+	obs_data_set_default_int(settings, S_STAGGER, STAGGER_NONE);
+	obs_data_set_default_double(settings, S_STAGGER_AMOUNT, 0.5);
+	obs_data_set_default_double(settings, S_FOCAL_X, 0.5);
+	obs_data_set_default_double(settings, S_FOCAL_Y, 0.5);
+	obs_data_set_default_int(settings, S_AUDIO_FADE, FADE_LINEAR);
 }
 
 static void motion_transition_start(void *data)
 {
 	transition_data_t *tr = data;
+	motion_trace_instant("trigger", tr->context);
 	tr->start_init = true;
 }
 
+static void destroy_plan(void *data)
+{
+	transition_plan_t *plan = data;
+	obs_scene_t *out_scene = plan->out_list.scene;
+	obs_scene_t *in_scene = plan->in_list.scene;
+	obs_scene_t *out_origin = plan->out_list.origin;
+	obs_scene_t *in_origin = plan->in_list.origin;
+
+	release_plan(plan);
+	obs_scene_release(in_scene);
+	obs_scene_release(out_scene);
+	obs_scene_release(in_origin);
+	obs_scene_release(out_origin);
+	arena_free(&plan->arena);
+	bfree(plan);
+}
+
+/*
+ * Publishes the new plan, or none, and retires the one it replaces.
+ * Render threads may still be drawing from the old plan; its scenes and
+ * memory go once they are done.
+ */
+static void publish_plan(transition_data_t *tr, transition_plan_t *plan,
+	bool remove_children)
+{
+	transition_plan_t *old = epoch_exchange((void *volatile *)&tr->plan,
+		plan);
+
+	if (!old)
+		return;
+
+	if (remove_children && !old->direct_render) {
+		obs_source_remove_active_child(tr->context, old->in_list.source);
+		obs_source_remove_active_child(tr->context, old->out_list.source);
+	}
+	epoch_retire(old, destroy_plan);
+}
+
 static void motion_transition_stop(void *data)
 {
 	transition_data_t *tr = data;
-	
-	obs_source_remove_active_child(tr->context, tr->in_list.source);
-	obs_source_remove_active_child(tr->context, tr->out_list.source);
-	obs_scene_release(tr->in_list.scene);
-	obs_scene_release(tr->out_list.scene);	
-	release_item_list(&tr->in_list);
-	release_item_list(&tr->out_list);
-	tr->transitioning = false;
+	uint64_t start = os_gettime_ns();
+
+	publish_plan(tr, NULL, true);
+	motion_trace_event("stop", tr->context, start, os_gettime_ns());
+}
+
+static bool stagger_changed(obs_properties_t *props, obs_property_t *p,
+	obs_data_t *settings)
+{
+	enum stagger_mode mode = (enum stagger_mode)obs_data_get_int(settings,
+		S_STAGGER);
+
+	obs_property_set_visible(obs_properties_get(props, S_STAGGER_AMOUNT),
+		mode != STAGGER_NONE);
+	obs_property_set_visible(obs_properties_get(props, S_STAGGER_REVERSE),
+		mode != STAGGER_NONE);
+	obs_property_set_visible(obs_properties_get(props, S_FOCAL_X),
+		mode == STAGGER_DISTANCE);
+	obs_property_set_visible(obs_properties_get(props, S_FOCAL_Y),
+		mode == STAGGER_DISTANCE);
+	UNUSED_PARAMETER(p);
+	return true;
 }
 
 static obs_properties_t *motion_transition_properties(void *data)
 {
 	obs_properties_t *props = obs_properties_create();
+	obs_property_t *p;
+
+	p = obs_properties_add_list(props, S_RENDER_MODE, T_RENDER_MODE,
+		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(p, T_RENDER_DUP, RENDER_DUPLICATE);
+	obs_property_list_add_int(p, T_RENDER_DIRECT, RENDER_DIRECT);
+
 	obs_properties_add_float_slider(props, S_BEZIER_X, T_BEZIER_X, -0.5, 0.5,
 		0.01);
 	obs_properties_add_float_slider(props, S_BEZIER_Y, T_BEZIER_Y, -0.5, 0.5,
 		0.01);
+
+	p = obs_properties_add_list(props, S_STAGGER, T_STAGGER,
+		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(p, T_STAGGER_NONE, STAGGER_NONE);
+	obs_property_list_add_int(p, T_STAGGER_Z_ORDER, STAGGER_Z_ORDER);
+	obs_property_list_add_int(p, T_STAGGER_DIST, STAGGER_DISTANCE);
+	obs_property_list_add_int(p, T_STAGGER_TYPE, STAGGER_SOURCE_TYPE);
+	obs_property_set_modified_callback(p, stagger_changed);
+	obs_properties_add_float_slider(props, S_STAGGER_AMOUNT,
+		T_STAGGER_AMOUNT, 0.0, 0.9, 0.01);
+	obs_properties_add_bool(props, S_STAGGER_REVERSE, T_STAGGER_REVERSE);
+	obs_properties_add_float_slider(props, S_FOCAL_X, T_FOCAL_X, 0.0, 1.0,
+		0.01);
+	obs_properties_add_float_slider(props, S_FOCAL_Y, T_FOCAL_Y, 0.0, 1.0,
+		0.01);
+
+	p = obs_properties_add_list(props, S_AUDIO_FADE, T_AUDIO_FADE,
+		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(p, T_FADE_LINEAR, FADE_LINEAR);
+	obs_property_list_add_int(p, T_FADE_EQUAL, FADE_EQUAL_POWER);
+	obs_property_list_add_int(p, T_FADE_MOTION, FADE_MOTION);
+
+	obs_properties_add_bool(props, S_GOVERNOR, T_GOVERNOR);
+	obs_properties_add_float(props, S_FRAME_BUDGET, T_FRAME_BUDGET, 0.1,
+		100.0, 0.1);
+	obs_properties_add_int(props, S_LAG_FRAMES, T_LAG_FRAMES, 1, 1000, 1);
+	obs_properties_add_int(props, S_SMALL_AREA, T_SMALL_AREA, 0, 8294400, 1);
 	return props;
 }
 
+/*
+ * When chaining from a plan that drew from a copy, that copy already holds
+ * what is on screen and is taken over instead of copying scene A again.
+ */
+static void duplicate_scenes(transition_data_t *tr, transition_plan_t *plan,
+	obs_scene_t *scene_a, obs_scene_t *scene_b, list_info_t *from)
+{
+	uint64_t start = os_gettime_ns();
+
+	if (from && from->scene != from->origin) {
+		obs_scene_addref(from->scene);
+		uncull_items(from);
+		plan->out_list.scene = from->scene;
+	} else {
+		plan->out_list.scene = obs_scene_duplicate(scene_a,
+			"motion-transition-a", OBS_SCENE_DUP_PRIVATE_REFS);
+	}
+	plan->out_list.source = obs_scene_get_source(plan->out_list.scene);
+	obs_source_add_active_child(tr->context, plan->out_list.source);
+
+	plan->in_list.scene = obs_scene_duplicate(scene_b,
+		"motion-transition-b", OBS_SCENE_DUP_PRIVATE_REFS);
+	plan->in_list.source = obs_scene_get_source(plan->in_list.scene);
+	obs_source_add_active_child(tr->context, plan->in_list.source);
+
+	motion_trace_event("scene duplicate", tr->context, start,
+		os_gettime_ns());
+	motion_stat_record(&tr->stats.duplicate_ns, os_gettime_ns() - start);
+	snapshot_scenes(plan);
+	if (from)
+		snapshot_inflight(plan, from);
+}
+
+/*
+ * Plans straight against the live scenes. Nothing is written to them, so
+ * there is nothing to copy before the transition or restore after it.
+ * Falls back to duplication if the scenes need something direct
+ * rendering cannot draw.
+ */
+static void use_original_scenes(transition_plan_t *plan, obs_scene_t *scene_a,
+	obs_scene_t *scene_b, const list_info_t *from)
+{
+	obs_scene_addref(scene_a);
+	obs_scene_addref(scene_b);
+	plan->out_list.scene = scene_a;
+	plan->in_list.scene = scene_b;
+
+	/* lets the snapshot look through nested scenes */
+	plan->direct_render = true;
+	snapshot_scenes(plan);
+	if (from)
+		snapshot_inflight(plan, from);
+	plan->direct_render = can_render_direct(plan);
+
+	if (!plan->direct_render) {
+		obs_scene_release(scene_a);
+		obs_scene_release(scene_b);
+		plan->out_list.scene = NULL;
+		plan->in_list.scene = NULL;
+	}
+}
+
+/*
+ * A switch while a plan is on screen chains from it: the new plan moves
+ * the items of the list being shown, from where they are now, to scene B.
+ * Only scene B is copied; the shown list's copy is reused if it has one.
+ */
+static transition_plan_t *build_plan(transition_data_t *tr,
+	transition_plan_t *running, obs_scene_t *scene_a, obs_scene_t *scene_b)
+{
+	transition_plan_t *plan = bzalloc(sizeof(*plan));
+	uint64_t plan_start = os_gettime_ns();
+	list_info_t *from = NULL;
+
+	if (running && tr->shown_time > 0.0f && tr->shown_time < 1.0f) {
+		from = tr->shown_time <= 0.5f ? &running->out_list :
+			&running->in_list;
+		if (from->origin)
+			scene_a = from->origin;
+		else
+			from = NULL;
+	}
+
+	plan->acc_x = tr->acc_x;
+	plan->acc_y = tr->acc_y;
+	plan->small_area = tr->small_area;
+	plan->stagger = tr->stagger;
+	plan->stagger_amount = tr->stagger_amount;
+	plan->stagger_reverse = tr->stagger_reverse;
+	plan->focal = tr->focal;
+
+	obs_scene_addref(scene_a);
+	obs_scene_addref(scene_b);
+	plan->out_list.origin = scene_a;
+	plan->in_list.origin = scene_b;
+
+	if (tr->render_mode == RENDER_DIRECT)
+		use_original_scenes(plan, scene_a, scene_b, from);
+
+	if (!plan->direct_render)
+		duplicate_scenes(tr, plan, scene_a, scene_b, from);
+
+	if (from)
+		motion_trace_instant("chain", tr->context);
+
+	create_item_list(plan);
+	motion_trace_event("plan build", tr->context, plan_start,
+		os_gettime_ns());
+	motion_stat_record(&tr->stats.plan_ns, os_gettime_ns() - plan_start);
+	return plan;
+}
+
 static void motion_transition_video_render(void *data, gs_effect_t *effect)
 {
 	transition_data_t *tr = data;
+	transition_plan_t *plan;
 
 	float t = obs_transition_get_time(tr->context);
 
-	if (tr->start_init) {
-
-		if (tr->transitioning)
-			motion_transition_stop(tr);
+	epoch_enter();
 
+	if (tr->start_init) {
 		obs_source_t *source_a = obs_transition_get_source(tr->context,
 			OBS_TRANSITION_SOURCE_A);
 		obs_scene_t *scene_a = obs_scene_from_source(source_a);
@@ -252,56 +581,93 @@ static void motion_transition_video_render(void *data, gs_effect_t *effect)
 		obs_source_t *source_b = obs_transition_get_source(tr->context,
 			OBS_TRANSITION_SOURCE_B);
 		obs_scene_t *scene_b = obs_scene_from_source(source_b);
-		tr->scene_transition = scene_a && scene_b;
-
-		if (tr->scene_transition) {
 
-			tr->out_list.scene = obs_scene_duplicate(scene_a,
-				"motion-transition-a", OBS_SCENE_DUP_PRIVATE_REFS);
-			tr->out_list.source = obs_scene_get_source(tr->out_list.scene);
-			obs_source_add_active_child(tr->context, tr->out_list.source);
-
-			tr->in_list.scene = obs_scene_duplicate(scene_b,
-				"motion-transition-b", OBS_SCENE_DUP_PRIVATE_REFS);
-			tr->in_list.source = obs_scene_get_source(tr->in_list.scene);
-			obs_source_add_active_child(tr->context, tr->in_list.source);
-
-			create_item_list(tr);
-			tr->transitioning = true;
+		/* the previous plan, if any, is retired by the swap */
+		if (scene_a && scene_b) {
+			transition_plan_t *running = epoch_load(
+				(void *volatile *)&tr->plan);
+			publish_plan(tr, build_plan(tr, running, scene_a,
+				scene_b), true);
+			governor_reset(tr);
+		} else {
+			publish_plan(tr, NULL, true);
 		}
+
 		obs_source_release(source_a);
 		obs_source_release(source_b);
+		tr->shown_time = 0.0f;
 		tr->start_init = false;
 	}
 
-	if (t > 0.0f && t < 1.0f && tr->scene_transition) {
-		if (t <= 0.5) {
-			update_item_information(tr->out_list.first_item, t);
-			obs_source_video_render(tr->out_list.source);
+	plan = epoch_load((void *volatile *)&tr->plan);
+
+	if (t > 0.0f && t < 1.0f && plan) {
+		uint64_t frame_start = os_gettime_ns();
+		uint64_t frame_ns;
+		list_info_t *list = t <= 0.5f ? &plan->out_list : &plan->in_list;
+
+		if (tr->governor.tier == TIER_DIRECT) {
+			obs_transition_video_render_direct(tr->context,
+				t <= 0.5f ? OBS_TRANSITION_SOURCE_A :
+				OBS_TRANSITION_SOURCE_B);
+			tr->shown_time = 0.0f;
 		} else {
-			update_item_information(tr->in_list.first_item, t);
-			obs_source_video_render(tr->in_list.source);
+			render_frame(tr, plan, list, t);
+			tr->shown_time = t;
 		}
+
+		frame_ns = os_gettime_ns() - frame_start;
+		governor_update(tr, frame_ns);
+		motion_trace_frame(frame_ns);
 	} else if (t <= 0.5f ) {
 		obs_transition_video_render_direct(tr->context,
 			OBS_TRANSITION_SOURCE_A);
+		tr->shown_time = 0.0f;
 	} else {
 		obs_transition_video_render_direct(tr->context,
 				OBS_TRANSITION_SOURCE_B);
+		tr->shown_time = 0.0f;
 	}
 
+	epoch_leave();
+}
+
+static inline float clamp_unit(float t)
+{
+	return t <= 0.0f ? 0.0f : (t >= 1.0f ? 1.0f : t);
+}
+
+static inline float lookup_gain(const float *ramp, float t)
+{
+	float pos, frac;
+	int idx;
+
+	if (t <= 0.0f)
+		return ramp[0];
+	if (t >= 1.0f)
+		return ramp[GAIN_STEPS];
+
+	pos = t * GAIN_STEPS;
+	idx = (int)pos;
+	frac = pos - (float)idx;
+	return ramp[idx] + (ramp[idx + 1] - ramp[idx]) * frac;
 }
 
+/* called from inside motion_transition_audio_render's epoch section */
 static float mix_a(void *data, float t)
 {
-	UNUSED_PARAMETER(data);
-	return 1.0f - t;
+	transition_data_t *tr = data;
+	struct gain_ramps *ramps = epoch_load((void *volatile *)&tr->ramps);
+
+	return ramps ? lookup_gain(ramps->a, t) : 1.0f - clamp_unit(t);
 }
 
 static float mix_b(void *data, float t)
 {
-	UNUSED_PARAMETER(data);
-	return t;
+	transition_data_t *tr = data;
+	struct gain_ramps *ramps = epoch_load((void *volatile *)&tr->ramps);
+
+	return ramps ? lookup_gain(ramps->b, t) : clamp_unit(t);
 }
 
 
@@ -310,39 +676,47 @@ static bool motion_transition_audio_render(void *data, uint64_t *ts_out,
 	size_t channels, size_t sample_rate)
 {
 	transition_data_t *tr = data;
-	return obs_transition_audio_render(tr->context, ts_out,
+	bool ret;
+
+	epoch_enter();
+	ret = obs_transition_audio_render(tr->context, ts_out,
 		audio, mixers, channels, sample_rate, mix_a, mix_b);
+	epoch_leave();
+	return ret;
 }
 
 static void motion_enum_all_sources(void *data,
 	obs_source_enum_proc_t enum_callback, void *param)
 {
 	transition_data_t* tr = data;
-	if (tr->out_list.source)
-		enum_callback(tr->context, tr->out_list.source, param);
+	transition_plan_t *plan;
+
+	epoch_enter();
+	plan = epoch_load((void *volatile *)&tr->plan);
 
-	if (tr->in_list.source)
-		enum_callback(tr->context, tr->in_list.source, param);
+	if (plan && plan->out_list.source)
+		enum_callback(tr->context, plan->out_list.source, param);
 
+	if (plan && plan->in_list.source)
+		enum_callback(tr->context, plan->in_list.source, param);
+
+	epoch_leave();
 }
 
 
 static void motion_enum_active_sources(void *data,
 	obs_source_enum_proc_t enum_callback, void *param)
 {
-	transition_data_t* tr = data;
-	if (tr->out_list.source && tr->transitioning)
-		enum_callback(tr->context, tr->out_list.source, param);
-
-	if (tr->in_list.source && tr->transitioning)
-		enum_callback(tr->context, tr->in_list.source, param);
+	/* a plan is only published while its transition runs */
+	motion_enum_all_sources(data, enum_callback, param);
 }
 
 static void *motion_transition_create(obs_data_t *settings, obs_source_t *context)
 {
 	transition_data_t *tr = bzalloc(sizeof(*tr));
 	tr->context = context;
-	UNUSED_PARAMETER(settings);
+	motion_runtime_add_source(context, &tr->stats);
+	motion_transition_update(tr, settings);
 	return tr;
 }
 
@@ -350,6 +724,10 @@ static void *motion_transition_create(obs_data_t *settings, obs_source_t *contex
 static void motion_transition_destroy(void *data)
 {
 	transition_data_t *tr = data;
+	motion_runtime_remove_source(&tr->stats);
+	publish_plan(tr, NULL, false);
+	if (tr->ramps)
+		epoch_retire(tr->ramps, bfree);
 	bfree(tr);
 }
 
@@ -360,9 +738,6 @@ static const char *motion_transition_get_name(void *unused)
 	return obs_module_text("Motion");
 }
 
-OBS_DECLARE_MODULE()
-OBS_MODULE_USE_DEFAULT_LOCALE("motion-transition", "en-US")
-
 struct obs_source_info motion_transition = {
 	.id = "motion-transition",
 	.type = OBS_SOURCE_TYPE_TRANSITION,
@@ -373,13 +748,9 @@ struct obs_source_info motion_transition = {
 	.video_render = motion_transition_video_render,
 	.audio_render = motion_transition_audio_render,
 	.get_properties = motion_transition_properties,
+	.get_defaults = motion_transition_defaults,
 	.enum_active_sources = motion_enum_active_sources,
 	.enum_all_sources = motion_enum_all_sources,
 	.transition_start = motion_transition_start,
 	.transition_stop = motion_transition_stop
 };
-
-bool obs_module_load(void) {
-	obs_register_source(&motion_transition);
-	return true;
-}
\ No newline at end of file
@@ -0,0 +1,950 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+#include "transition-plan.h"
+#include "item-match.h"
+#include "../helper.h"
+#include "../thread-pool.h"
+#include <graphics/math-defs.h>
+#include <math.h>
+
+#define PLAN_CHUNK_SIZE   64
+#define EVAL_CHUNK_SIZE   128
+#define PLAN_MAX_NESTING  8
+
+struct snapshot_walk {
+	transition_plan_t   *plan;
+	list_info_t         *list;
+	const item_parent_t *parent;
+	size_t              count;
+	int                 depth;
+};
+
+/*
+ * Groups are always looked through. Nested scenes are only looked through
+ * when drawing directly: in a duplicated scene they are still the shared
+ * live scene, and writing to their items would show everywhere they are
+ * used.
+ */
+static obs_scene_t *get_child_scene(struct snapshot_walk *walk,
+	obs_sceneitem_t *item)
+{
+	if (walk->depth >= PLAN_MAX_NESTING)
+		return NULL;
+	if (obs_sceneitem_is_group(item))
+		return obs_sceneitem_group_get_scene(item);
+	if (walk->plan->direct_render)
+		return obs_scene_from_source(obs_sceneitem_get_source(item));
+	return NULL;
+}
+
+static inline void transform_point(const struct matrix4 *m,
+	const struct vec2 *v, struct vec2 *dst)
+{
+	float x = v->x * m->x.x + v->y * m->y.x + m->t.x;
+	float y = v->x * m->x.y + v->y * m->y.y + m->t.y;
+	dst->x = x;
+	dst->y = y;
+}
+
+static void to_world(const item_parent_t *parent,
+	const struct obs_transform_info *local, struct obs_transform_info *world)
+{
+	*world = *local;
+	if (!parent)
+		return;
+
+	transform_point(&parent->transform, &local->pos, &world->pos);
+	world->scale.x = local->scale.x * parent->scale.x;
+	world->scale.y = local->scale.y * parent->scale.y;
+	world->bounds.x = local->bounds.x * fabsf(parent->scale.x);
+	world->bounds.y = local->bounds.y * fabsf(parent->scale.y);
+	world->rot = parent->mirrored ? parent->rot - local->rot :
+		parent->rot + local->rot;
+}
+
+/*
+ * Inverse of to_world. Exact for parents without skew, which covers
+ * everything but a rotated child in a non-uniformly scaled group. A
+ * mirrored parent turns its children the other way, in both directions.
+ */
+static bool to_local(const item_parent_t *parent,
+	const struct obs_transform_info *world, struct obs_transform_info *local)
+{
+	const struct matrix4 *m;
+	float det, x, y;
+
+	*local = *world;
+	if (!parent)
+		return true;
+
+	m = &parent->transform;
+	det = m->x.x * m->y.y - m->x.y * m->y.x;
+	if (det == 0.0f)
+		return false;
+
+	x = world->pos.x - m->t.x;
+	y = world->pos.y - m->t.y;
+	local->pos.x = (x * m->y.y - y * m->y.x) / det;
+	local->pos.y = (y * m->x.x - x * m->x.y) / det;
+	local->scale.x = world->scale.x / parent->scale.x;
+	local->scale.y = world->scale.y / parent->scale.y;
+	local->bounds.x = world->bounds.x / fabsf(parent->scale.x);
+	local->bounds.y = world->bounds.y / fabsf(parent->scale.y);
+	local->rot = parent->mirrored ? parent->rot - world->rot :
+		world->rot - parent->rot;
+	return true;
+}
+
+/*
+ * Whether libobs draws the item into a texture of its own first, as it
+ * does for a crop, a scale filter or a blending other than the default.
+ */
+static bool uses_item_texture(obs_sceneitem_t *item,
+	const struct obs_sceneitem_crop *crop)
+{
+	if (crop->left || crop->top || crop->right || crop->bottom)
+		return true;
+	if (obs_sceneitem_get_scale_filter(item) != OBS_SCALE_DISABLE)
+		return true;
+#if LIBOBS_API_MAJOR_VER >= 27
+	if (obs_sceneitem_get_blending_mode(item) != OBS_BLEND_NORMAL)
+		return true;
+#endif
+#if LIBOBS_API_MAJOR_VER > 27 || \
+	(LIBOBS_API_MAJOR_VER == 27 && LIBOBS_API_MINOR_VER >= 1)
+	if (obs_sceneitem_get_blending_method(item) !=
+			OBS_BLEND_METHOD_DEFAULT)
+		return true;
+#endif
+	return false;
+}
+
+static void find_video_filter(obs_source_t *parent, obs_source_t *filter,
+	void *param)
+{
+	bool *found = param;
+	const char *id = obs_source_get_id(filter);
+
+	if (obs_source_enabled(filter) &&
+			(obs_source_get_output_flags(filter) & OBS_SOURCE_VIDEO) &&
+			(!id || strcmp(id, "motion-filter") != 0))
+		*found = true;
+
+	UNUSED_PARAMETER(parent);
+}
+
+/*
+ * Whether the source has filters that draw, which libobs applies to the
+ * group or nested scene as a whole. Motion filters only move items.
+ */
+static bool has_video_filters(obs_source_t *source)
+{
+	bool found = false;
+	obs_source_enum_filters(source, find_video_filter, &found);
+	return found;
+}
+
+/*
+ * Splits a parent transform into rotation and scale, R(rot) S(scale), with
+ * a mirror kept as a negative y scale.
+ */
+static void set_parent_transform(item_parent_t *parent,
+	const struct matrix4 *transform)
+{
+	float det = transform->x.x * transform->y.y -
+		transform->x.y * transform->y.x;
+
+	parent->transform = *transform;
+	parent->mirrored = det < 0.0f;
+	parent->scale.x = hypotf(transform->x.x, transform->x.y);
+	parent->scale.y = hypotf(transform->y.x, transform->y.y);
+	if (parent->mirrored)
+		parent->scale.y = -parent->scale.y;
+	parent->rot = (float)DEG(atan2f(transform->x.y, transform->x.x));
+}
+
+/*
+ * Builds the parent for the items of a group or nested scene: the item's
+ * own draw transform, shifted by its crop, on top of its parent's.
+ */
+static item_parent_t *create_parent(struct snapshot_walk *walk,
+	obs_sceneitem_t *item, const struct obs_transform_info *info,
+	const struct obs_sceneitem_crop *crop)
+{
+	item_parent_t *parent = arena_alloc(&walk->plan->arena,
+		sizeof(item_parent_t));
+	obs_source_t *source = obs_sceneitem_get_source(item);
+	float width = (float)obs_source_get_width(source) -
+		(float)(crop->left + crop->right);
+	float height = (float)obs_source_get_height(source) -
+		(float)(crop->top + crop->bottom);
+	struct matrix4 local, transform;
+
+	get_item_draw_transform(info, width, height, &local);
+	local.t.x -= crop->left * local.x.x + crop->top * local.y.x;
+	local.t.y -= crop->left * local.x.y + crop->top * local.y.y;
+
+	if (walk->parent)
+		matrix4_mul(&transform, &local, &walk->parent->transform);
+	else
+		transform = local;
+	set_parent_transform(parent, &transform);
+
+	parent->visible = obs_sceneitem_visible(item) &&
+		(!walk->parent || walk->parent->visible);
+	parent->textured = uses_item_texture(item, crop) ||
+		has_video_filters(source) ||
+		(walk->parent && walk->parent->textured);
+	return parent;
+}
+
+static bool snapshot_item(obs_scene_t *scene, obs_sceneitem_t *item, void *data)
+{
+	struct snapshot_walk *walk = data;
+	list_info_t *list = walk->list;
+	obs_source_t *source = obs_sceneitem_get_source(item);
+	obs_scene_t *child = get_child_scene(walk, item);
+	struct obs_transform_info info;
+	struct obs_sceneitem_crop crop;
+	item_snapshot_t *snap;
+
+	obs_sceneitem_get_info(item, &info);
+	obs_sceneitem_get_crop(item, &crop);
+
+	if (child) {
+		const item_parent_t *parent = walk->parent;
+
+		/*
+		 * libobs refits a group to its items once they move, shifting
+		 * the group item away from the parent transform taken here.
+		 * The duplicate is thrown away after the transition, so the
+		 * resize stays deferred for good.
+		 */
+		if (!walk->plan->direct_render && obs_sceneitem_is_group(item))
+			obs_sceneitem_defer_group_resize_begin(item);
+
+		walk->parent = create_parent(walk, item, &info, &crop);
+		walk->depth++;
+		obs_scene_enum_items(child, snapshot_item, walk);
+		walk->depth--;
+		walk->parent = parent;
+		return true;
+	}
+
+	if (list->num_snapshots == list->max_snapshots)
+		return false;
+
+	snap = &list->snapshots[list->num_snapshots++];
+
+	snap->item = item;
+	snap->source = source;
+	snap->parent = walk->parent;
+	snap->name = obs_source_get_name(source);
+	snap->base_width = (float)obs_source_get_base_width(source);
+	snap->base_height = (float)obs_source_get_base_height(source);
+	snap->width = (float)obs_source_get_width(source);
+	snap->height = (float)obs_source_get_height(source);
+	snap->visible = obs_sceneitem_visible(item) &&
+		(!walk->parent || walk->parent->visible);
+	snap->crop = crop;
+	snap->textured = uses_item_texture(item, &crop);
+	to_world(walk->parent, &info, &snap->info);
+
+	UNUSED_PARAMETER(scene);
+	return true;
+}
+
+static bool count_item(obs_scene_t *scene, obs_sceneitem_t *item, void *data)
+{
+	struct snapshot_walk *walk = data;
+	obs_scene_t *child = get_child_scene(walk, item);
+
+	if (child) {
+		walk->depth++;
+		obs_scene_enum_items(child, count_item, walk);
+		walk->depth--;
+	} else {
+		walk->count++;
+	}
+
+	UNUSED_PARAMETER(scene);
+	return true;
+}
+
+static int compare_name_index(const void *a, const void *b)
+{
+	const name_index_t *index_a = a;
+	const name_index_t *index_b = b;
+	int cmp = strcmp(index_a->name ? index_a->name : "",
+		index_b->name ? index_b->name : "");
+
+	if (cmp != 0)
+		return cmp;
+
+	return index_a->idx < index_b->idx ? -1 : index_a->idx > index_b->idx;
+}
+
+static void build_name_index(transition_plan_t *plan, list_info_t *list)
+{
+	list->index = arena_alloc(&plan->arena,
+		sizeof(name_index_t) * list->num_snapshots);
+
+	for (size_t i = 0; i < list->num_snapshots; i++) {
+		list->index[i].name = list->snapshots[i].name;
+		list->index[i].idx = i;
+	}
+
+	qsort(list->index, list->num_snapshots, sizeof(name_index_t),
+		compare_name_index);
+}
+
+static void plan_item(transition_plan_t *plan, bool transition_out,
+	item_snapshot_t *snap_a, size_t match, moving_item_t *next)
+{
+	bool transform_variation = false;
+	list_info_t *list_cmp;
+	struct obs_transform_info *info_a, *info_b;
+	struct obs_sceneitem_crop *crop_a, *crop_b;
+	item_snapshot_t *snap_b;
+
+	if (transition_out) {
+		list_cmp = &plan->in_list;
+		info_a = &next->start_info;
+		info_b = &next->end_info;
+		crop_a = &next->start_crop;
+		crop_b = &next->end_crop;
+	} else {
+		list_cmp = &plan->out_list;
+		info_a = &next->end_info;
+		info_b = &next->start_info;
+		crop_a = &next->end_crop;
+		crop_b = &next->start_crop;
+	}
+
+	*info_a = snap_a->info;
+	*crop_a = snap_a->crop;
+	snap_b = match == MATCH_NONE ? NULL : &list_cmp->snapshots[match];
+
+	if (snap_b) {
+		*info_b = snap_b->info;
+		*crop_b = snap_b->crop;
+		transform_variation = same_transform_type(info_a, info_b);
+	} else {
+		*info_b = snap_a->info;
+		*crop_b = snap_a->crop;
+	}
+
+	if (transform_variation) {
+		float t = transition_out ? plan->acc_x : 1 - plan->acc_x;
+		float f = transition_out ? plan->acc_y : 1 - plan->acc_y;
+		next->control_pos.x = (1 - t) * info_a->pos.x + t * info_b->pos.x;
+		next->control_pos.y = (1 - f) * info_a->pos.y + f * info_b->pos.y;
+		next->type = VARIATION_MOTION;
+	} else {
+		float w = snap_a->base_width * info_a->scale.x;
+		float h = snap_a->base_height * info_a->scale.y;
+		info_b->pos.x = info_a->pos.x + w / 2;
+		info_b->pos.y = info_a->pos.y + h / 2;
+		info_b->scale.x = 0;
+		info_b->scale.y = 0;
+		next->type = transition_out ? VARIATION_ZOOMOUT : VARIATION_ZOOMIN;
+	}
+
+	next->item = snap_a->item;
+	next->source = snap_a->source;
+	next->parent = snap_a->parent;
+	next->width = snap_a->width;
+	next->height = snap_a->height;
+	next->visible = snap_a->visible;
+}
+
+static void plan_items_task(void *param, size_t start, size_t end)
+{
+	transition_plan_t *plan = param;
+	size_t num_out = plan->out_list.num_items;
+
+	for (size_t i = start; i < end; i++) {
+		bool transition_out = i < num_out;
+		list_info_t *list = transition_out ? &plan->out_list : &plan->in_list;
+		size_t idx = transition_out ? i : i - num_out;
+
+		plan_item(plan, transition_out, &list->snapshots[idx],
+			list->match[idx], &list->items[idx]);
+	}
+}
+
+/*
+ * Flattens the scene depth first, so the snapshots of a group's items take
+ * the group's place in z-order and one name index covers every level.
+ */
+static void snapshot_list(transition_plan_t *plan, list_info_t *list)
+{
+	struct snapshot_walk walk = {plan, list, NULL, 0, 0};
+
+	obs_scene_enum_items(list->scene, count_item, &walk);
+	list->snapshots = arena_alloc(&plan->arena,
+		sizeof(item_snapshot_t) * walk.count);
+	list->num_snapshots = 0;
+	list->max_snapshots = walk.count;
+
+	obs_scene_enum_items(list->scene, snapshot_item, &walk);
+}
+
+/*
+ * All plan memory comes from the plan's arena, which is emptied or freed
+ * in one step once the plan is done.
+ */
+void snapshot_scenes(transition_plan_t *plan)
+{
+	arena_reset(&plan->arena);
+	snapshot_list(plan, &plan->out_list);
+	snapshot_list(plan, &plan->in_list);
+}
+
+struct item_index {
+	const obs_sceneitem_t *item;
+	size_t              idx;
+};
+
+static int compare_item_index(const void *a, const void *b)
+{
+	const struct item_index *index_a = a;
+	const struct item_index *index_b = b;
+	uintptr_t item_a = (uintptr_t)index_a->item;
+	uintptr_t item_b = (uintptr_t)index_b->item;
+
+	if (item_a != item_b)
+		return item_a < item_b ? -1 : 1;
+
+	return index_a->idx < index_b->idx ? -1 : index_a->idx > index_b->idx;
+}
+
+/*
+ * A transition started while another runs picks up from what is on screen:
+ * the out list takes the last evaluated transform and crop of each item
+ * the running plan was showing. Items are paired by scene item, as the
+ * two plans may flatten nested scenes differently and a source can be
+ * shown more than once; a nested scene shown twice lists its items twice,
+ * which pair up in order. A plan over a new copy of the live scene has
+ * items of its own and starts from the scene as it is.
+ */
+void snapshot_inflight(transition_plan_t *plan, const list_info_t *from)
+{
+	list_info_t *list = &plan->out_list;
+	struct item_index *running, *snapped;
+	size_t i = 0, j = 0;
+
+	if (!from->num_items || !list->num_snapshots)
+		return;
+
+	running = arena_alloc(&plan->arena, sizeof(*running) *
+		from->num_items);
+	for (size_t k = 0; k < from->num_items; k++) {
+		running[k].item = from->items[k].item;
+		running[k].idx = k;
+	}
+
+	snapped = arena_alloc(&plan->arena, sizeof(*snapped) *
+		list->num_snapshots);
+	for (size_t k = 0; k < list->num_snapshots; k++) {
+		snapped[k].item = list->snapshots[k].item;
+		snapped[k].idx = k;
+	}
+
+	qsort(running, from->num_items, sizeof(*running), compare_item_index);
+	qsort(snapped, list->num_snapshots, sizeof(*snapped),
+		compare_item_index);
+
+	while (i < from->num_items && j < list->num_snapshots) {
+		uintptr_t item_a = (uintptr_t)running[i].item;
+		uintptr_t item_b = (uintptr_t)snapped[j].item;
+		size_t from_idx;
+		item_snapshot_t *snap;
+
+		if (item_a != item_b) {
+			if (item_a < item_b)
+				i++;
+			else
+				j++;
+			continue;
+		}
+
+		from_idx = running[i++].idx;
+		snap = &list->snapshots[snapped[j++].idx];
+		if (from->items[from_idx].visible) {
+			snap->info = from->states[from_idx].info;
+			snap->crop = from->states[from_idx].crop;
+		}
+	}
+}
+
+/*
+ * Shows again the items a commit hid for being culled, so a duplicated
+ * scene can be snapshotted by the next plan with its own visibility.
+ */
+void uncull_items(list_info_t *list)
+{
+	for (size_t i = 0; i < list->num_items; i++) {
+		moving_item_t *mv = &list->items[i];
+
+		if (mv->culled) {
+			obs_sceneitem_set_visible(mv->item, true);
+			mv->culled = false;
+		}
+	}
+}
+
+/*
+ * Direct rendering draws each source with a rebuilt transform matrix only.
+ * Items libobs draws through a texture of their own, for a crop, a scale
+ * filter or a blending mode, on the item or on a group or nested scene
+ * around it, need the duplicated copy, and so do scenes, groups and
+ * nested scenes with filters of their own.
+ */
+bool can_render_direct(transition_plan_t *plan)
+{
+	list_info_t *lists[2] = { &plan->out_list, &plan->in_list };
+
+	for (size_t i = 0; i < 2; i++) {
+		if (has_video_filters(obs_scene_get_source(lists[i]->scene)))
+			return false;
+
+		for (size_t j = 0; j < lists[i]->num_snapshots; j++) {
+			item_snapshot_t *snap = &lists[i]->snapshots[j];
+			if (snap->textured)
+				return false;
+			if (snap->parent && snap->parent->textured)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+static size_t type_index(const char **types, size_t *num_types,
+	const char *id)
+{
+	size_t i;
+
+	if (!id)
+		id = "";
+
+	for (i = 0; i < *num_types; i++) {
+		if (strcmp(types[i], id) == 0)
+			return i;
+	}
+
+	types[(*num_types)++] = id;
+	return i;
+}
+
+static float stagger_value(transition_plan_t *plan, item_snapshot_t *snap,
+	size_t idx, const char **types, size_t *num_types)
+{
+	struct vec2 min, max;
+	float dx, dy;
+
+	switch (plan->stagger) {
+	case STAGGER_DISTANCE:
+		if (!get_item_bbox(&snap->info, &snap->crop, snap->width,
+				snap->height, &min, &max))
+			min = max = snap->info.pos;
+		dx = (min.x + max.x) / 2.0f - plan->focal.x * plan->canvas_width;
+		dy = (min.y + max.y) / 2.0f - plan->focal.y * plan->canvas_height;
+		return sqrtf(dx * dx + dy * dy);
+	case STAGGER_SOURCE_TYPE:
+		return (float)type_index(types, num_types,
+			obs_source_get_id(snap->source));
+	default:
+		return (float)idx;
+	}
+}
+
+/* spreads a list's raw values over [0, 1] */
+static void normalize_keys(float *keys, size_t count)
+{
+	float min = 0.0f, max = 0.0f;
+
+	for (size_t i = 0; i < count; i++) {
+		if (!i || keys[i] < min)
+			min = keys[i];
+		if (!i || keys[i] > max)
+			max = keys[i];
+	}
+
+	for (size_t i = 0; i < count; i++)
+		keys[i] = max > min ? (keys[i] - min) / (max - min) : 0.0f;
+}
+
+/*
+ * Stagger keys in [0, 1] for both lists, laid out like the items. A
+ * matched pair moves as one across the switch at t = 0.5, so the in item
+ * takes its partner's key.
+ */
+static float *get_stagger_keys(transition_plan_t *plan)
+{
+	list_info_t *out_list = &plan->out_list;
+	list_info_t *in_list = &plan->in_list;
+	size_t count = out_list->num_items + in_list->num_items;
+	float *keys = arena_alloc(&plan->arena, sizeof(float) * count);
+	const char **types = arena_alloc(&plan->arena,
+		sizeof(const char *) * count);
+	size_t num_types = 0;
+
+	for (size_t i = 0; i < out_list->num_items; i++)
+		keys[i] = stagger_value(plan, &out_list->snapshots[i], i,
+			types, &num_types);
+	for (size_t i = 0; i < in_list->num_items; i++)
+		keys[out_list->num_items + i] = stagger_value(plan,
+			&in_list->snapshots[i], i, types, &num_types);
+
+	normalize_keys(keys, out_list->num_items);
+	normalize_keys(keys + out_list->num_items, in_list->num_items);
+
+	for (size_t i = 0; i < in_list->num_items; i++) {
+		if (in_list->match[i] != MATCH_NONE)
+			keys[out_list->num_items + i] = keys[in_list->match[i]];
+	}
+
+	if (plan->stagger_reverse) {
+		for (size_t i = 0; i < count; i++)
+			keys[i] = 1.0f - keys[i];
+	}
+
+	return keys;
+}
+
+/*
+ * The item plays over [start, start + width] of its own variation: the
+ * whole transition for a motion, one half for a zoom.
+ */
+static void set_window(item_window_t *win, enum variation_type type,
+	float start, float width)
+{
+	win->scale = 1.0f / width;
+
+	if (type == VARIATION_MOTION) {
+		win->offset = -start / width;
+		win->lo = 0.0f;
+		win->hi = 1.0f;
+	} else if (type == VARIATION_ZOOMOUT) {
+		win->offset = -start / (2.0f * width);
+		win->lo = 0.0f;
+		win->hi = 0.5f;
+	} else {
+		win->offset = 0.5f - (1.0f + start) / (2.0f * width);
+		win->lo = 0.5f;
+		win->hi = 1.0f;
+	}
+}
+
+/*
+ * Staggering spreads the items' start times over the first 'amount' of
+ * the transition, each item taking the rest to play. Without it every
+ * window is the identity.
+ */
+static void build_schedule(transition_plan_t *plan)
+{
+	list_info_t *out_list = &plan->out_list;
+	size_t count = out_list->num_items + plan->in_list.num_items;
+	float amount = plan->stagger == STAGGER_NONE ? 0.0f :
+		plan->stagger_amount;
+	float *keys = NULL;
+
+	if (amount > 0.0f)
+		keys = get_stagger_keys(plan);
+
+	for (size_t i = 0; i < count; i++) {
+		float start = keys ? keys[i] * amount : 0.0f;
+
+		set_window(&out_list->windows[i], out_list->items[i].type,
+			start, 1.0f - amount);
+		out_list->states[i].time = -1.0f;
+	}
+}
+
+/*
+ * Plan construction runs in three steps: both scenes are snapshotted in
+ * z-order, items are paired through the name indexes, and every item is
+ * planned in parallel chunks, each written to its own z-order slot so no
+ * merge pass is needed.
+ */
+void create_item_list(transition_plan_t *plan)
+{
+	list_info_t *out_list = &plan->out_list;
+	list_info_t *in_list = &plan->in_list;
+	struct obs_video_info ovi;
+
+	if (obs_get_video_info(&ovi)) {
+		plan->canvas_width = (float)ovi.base_width;
+		plan->canvas_height = (float)ovi.base_height;
+	}
+
+	build_name_index(plan, out_list);
+	build_name_index(plan, in_list);
+	match_items(plan);
+
+	out_list->num_items = out_list->num_snapshots;
+	in_list->num_items = in_list->num_snapshots;
+	out_list->items = arena_alloc(&plan->arena, sizeof(moving_item_t) *
+		(out_list->num_items + in_list->num_items));
+	in_list->items = out_list->items + out_list->num_items;
+	out_list->states = arena_alloc(&plan->arena, sizeof(item_state_t) *
+		(out_list->num_items + in_list->num_items));
+	in_list->states = out_list->states + out_list->num_items;
+	out_list->windows = arena_alloc(&plan->arena, sizeof(item_window_t) *
+		(out_list->num_items + in_list->num_items));
+	in_list->windows = out_list->windows + out_list->num_items;
+
+	thread_pool_run(out_list->num_items + in_list->num_items,
+		PLAN_CHUNK_SIZE, plan_items_task, plan);
+	build_schedule(plan);
+
+	if (plan->direct_render) {
+		for (size_t i = 0; i < out_list->num_items + in_list->num_items;
+				i++)
+			obs_source_addref(out_list->items[i].source);
+	}
+}
+
+static void release_item_list(list_info_t *list)
+{
+	list->scene = NULL;
+	list->origin = NULL;
+	list->source = NULL;
+	list->items = NULL;
+	list->states = NULL;
+	list->windows = NULL;
+	list->num_items = 0;
+	list->snapshots = NULL;
+	list->index = NULL;
+	list->match = NULL;
+	list->num_snapshots = 0;
+	list->max_snapshots = 0;
+}
+
+void release_plan(transition_plan_t *plan)
+{
+	if (plan->direct_render) {
+		size_t count = plan->out_list.num_items + plan->in_list.num_items;
+		for (size_t i = 0; i < count; i++)
+			obs_source_release(plan->out_list.items[i].source);
+	}
+
+	release_item_list(&plan->in_list);
+	release_item_list(&plan->out_list);
+	arena_reset(&plan->arena);
+}
+
+/*
+ * An item is culled when it is zoomed down to nothing or sits entirely
+ * outside the canvas. Also records the size and placement hints the
+ * governor uses to pick items to degrade.
+ */
+static bool is_culled(transition_plan_t *plan, moving_item_t *mv,
+	const struct obs_transform_info *info,
+	const struct obs_sceneitem_crop *crop)
+{
+	struct vec2 min, max;
+	bool culled;
+
+	if (mv->width <= 0.0f || mv->height <= 0.0f)
+		return false;
+
+	if (!get_item_bbox(info, crop, mv->width, mv->height, &min, &max))
+		culled = true;
+	else if (plan->canvas_width <= 0.0f || plan->canvas_height <= 0.0f)
+		culled = false;
+	else
+		culled = max.x <= 0.0f || max.y <= 0.0f ||
+			min.x >= plan->canvas_width || min.y >= plan->canvas_height;
+
+	if (!culled) {
+		float dx = (min.x + max.x - plan->canvas_width) / 2.0f;
+		float dy = (min.y + max.y - plan->canvas_height) / 2.0f;
+		mv->small = (max.x - min.x) * (max.y - min.y) <
+			plan->small_area;
+		mv->distant = fabsf(dx) > plan->canvas_width / 4.0f ||
+			fabsf(dy) > plan->canvas_height / 4.0f;
+	}
+
+	return culled;
+}
+
+static void eval_item(moving_item_t *mv, float time,
+	struct obs_transform_info *info, struct obs_sceneitem_crop *crop)
+{
+	float t;
+
+	if (mv->type == VARIATION_MOTION) {
+		t = time;
+		*info = mv->end_info;
+		vec_bezier(mv->start_info.pos, mv->control_pos,
+			mv->end_info.pos, &info->pos, t);
+		vec_linear(mv->start_info.bounds, mv->end_info.bounds,
+			&info->bounds, t);
+		crop_linear(mv->start_crop, mv->end_crop, crop, t);
+		info->rot = (1.0f - t) * mv->start_info.rot +
+			t * mv->end_info.rot;
+	} else if (mv->type == VARIATION_ZOOMIN) {
+		t = time * 2 - 1.0f;
+		*info = mv->end_info;
+		*crop = mv->end_crop;
+		vec_linear(mv->start_info.pos, mv->end_info.pos,
+			&info->pos, t);
+	} else {
+		t = time * 2;
+		*info = mv->start_info;
+		*crop = mv->start_crop;
+		vec_linear(mv->start_info.pos, mv->end_info.pos,
+			&info->pos, t);
+	}
+
+	vec_linear(mv->start_info.scale, mv->end_info.scale, &info->scale, t);
+}
+
+struct eval_job {
+	transition_plan_t         *plan;
+	list_info_t               *list;
+	float                     time;
+	enum governor_tier        tier;
+	uint32_t                  frame;
+};
+
+static void evaluate_task(void *param, size_t start, size_t end)
+{
+	struct eval_job *job = param;
+	list_info_t *list = job->list;
+
+	for (size_t i = start; i < end; i++) {
+		moving_item_t *mv = &list->items[i];
+		item_state_t *st = &list->states[i];
+		const item_window_t *win = &list->windows[i];
+		float t = fminf(fmaxf(job->time * win->scale + win->offset,
+			win->lo), win->hi);
+
+		/* outside its window an item holds its pose and is left alone */
+		st->skip = !mv->visible || t == st->time ||
+			(job->tier >= TIER_HALF_RATE && mv->distant &&
+			((i + job->frame) & 1));
+		if (st->skip)
+			continue;
+
+		st->time = t;
+		eval_item(mv, t, &st->info, &st->crop);
+		st->culled = is_culled(job->plan, mv, &st->info, &st->crop);
+	}
+}
+
+/*
+ * Each item only writes its own staging slot, so large lists are split
+ * across the worker pool; the results do not depend on the split, and
+ * the commit pass that follows stays serial, in z-order.
+ */
+void evaluate_items(transition_plan_t *plan, list_info_t *list, float time,
+	enum governor_tier tier, uint32_t frame)
+{
+	struct eval_job job = {plan, list, time, tier, frame};
+
+	if (list->num_items > EVAL_CHUNK_SIZE)
+		thread_pool_run(list->num_items, EVAL_CHUNK_SIZE,
+			evaluate_task, &job);
+	else
+		evaluate_task(&job, 0, list->num_items);
+}
+
+/*
+ * Pushes the staged transforms to the duplicated scene, mapped back from
+ * canvas space into the item's group. Culled items are hidden so libobs
+ * does not render them; only visibility changes are sent, and items
+ * hidden by the user are never touched.
+ */
+void commit_items(transition_plan_t *plan, list_info_t *list,
+	enum governor_tier tier, uint64_t *touched, uint64_t *setters)
+{
+	UNUSED_PARAMETER(plan);
+
+	for (size_t i = 0; i < list->num_items; i++) {
+		moving_item_t *mv = &list->items[i];
+		item_state_t *st = &list->states[i];
+		struct obs_transform_info info;
+
+		if (st->skip)
+			continue;
+
+		if (st->culled != mv->culled) {
+			obs_sceneitem_set_visible(mv->item, !st->culled);
+			mv->culled = st->culled;
+			(*setters)++;
+		}
+
+		if (st->culled || !to_local(mv->parent, &st->info, &info))
+			continue;
+
+		if (mv->type == VARIATION_MOTION &&
+				!(tier >= TIER_SKIP_SMALL && mv->small)) {
+			obs_sceneitem_set_bounds(mv->item, &info.bounds);
+			obs_sceneitem_set_crop(mv->item, &st->crop);
+			obs_sceneitem_set_rot(mv->item, info.rot);
+			(*setters) += 3;
+		}
+
+		obs_sceneitem_set_pos(mv->item, &info.pos);
+		obs_sceneitem_set_scale(mv->item, &info.scale);
+		(*setters) += 2;
+		(*touched)++;
+	}
+}
+
+/*
+ * Zero-duplication path: draws the original scene's sources in z-order
+ * with the staged transforms, leaving the scene items untouched.
+ */
+void render_items(transition_plan_t *plan, list_info_t *list,
+	uint64_t *touched)
+{
+	UNUSED_PARAMETER(plan);
+
+	for (size_t i = 0; i < list->num_items; i++) {
+		moving_item_t *mv = &list->items[i];
+		item_state_t *st = &list->states[i];
+
+		if (!mv->visible)
+			continue;
+
+		if (!st->skip) {
+			mv->culled = st->culled;
+			if (!mv->culled)
+				get_item_draw_transform(&st->info, mv->width,
+					mv->height, &mv->draw_transform);
+			(*touched)++;
+		}
+
+		if (mv->culled)
+			continue;
+
+		gs_matrix_push();
+		gs_matrix_mul(&mv->draw_transform);
+		obs_source_video_render(mv->source);
+		gs_matrix_pop();
+	}
+}
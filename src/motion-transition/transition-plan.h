@@ -0,0 +1,192 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+#pragma once
+
+#include <obs-module.h>
+#include <graphics/matrix4.h>
+#include "../arena.h"
+
+/*
+ * Transition plan: which items move, how, and their per-frame state. Only
+ * plain scene and scene item calls are made from here, so the plan can be
+ * built and driven outside of OBS (see bench/).
+ */
+
+enum variation_type {
+	VARIATION_MOTION = 0,
+	VARIATION_ZOOMOUT = 1,
+	VARIATION_ZOOMIN = 2
+};
+
+enum stagger_mode {
+	STAGGER_NONE = 0,
+	STAGGER_Z_ORDER = 1,
+	STAGGER_DISTANCE = 2,
+	STAGGER_SOURCE_TYPE = 3
+};
+
+enum governor_tier {
+	TIER_FULL = 0,
+	TIER_SKIP_SMALL = 1,
+	TIER_HALF_RATE = 2,
+	TIER_DIRECT = 3
+};
+
+typedef struct item_parent item_parent_t;
+typedef struct moving_item moving_item_t;
+typedef struct item_snapshot item_snapshot_t;
+typedef struct item_state item_state_t;
+typedef struct item_window item_window_t;
+typedef struct name_index name_index_t;
+typedef struct list_info list_info_t;
+typedef struct transition_plan transition_plan_t;
+
+/*
+ * A group, or in direct mode a nested scene, that the plan looked
+ * through. The transform maps the child scene's coordinates to the canvas
+ * and is built once per level. Items below it are planned in canvas
+ * space and mapped back into their own scene when committed. 'textured'
+ * marks a level libobs draws through a texture or filters of its own.
+ */
+struct item_parent {
+	struct matrix4            transform;
+	struct vec2               scale;
+	float                     rot;
+	bool                      mirrored;
+	bool                      visible;
+	bool                      textured;
+};
+
+struct moving_item {
+	obs_sceneitem_t           *item;
+	obs_source_t              *source;
+	const item_parent_t       *parent;
+	enum variation_type       type;
+	struct obs_transform_info start_info;
+	struct obs_transform_info end_info;
+	struct obs_sceneitem_crop start_crop;
+	struct obs_sceneitem_crop end_crop;
+	struct vec2               control_pos;
+	struct matrix4            draw_transform;
+	float                     width;
+	float                     height;
+	bool                      visible;
+	bool                      culled;
+	bool                      small;
+	bool                      distant;
+};
+
+/*
+ * Everything the plan needs from an item, read once up front so matching
+ * and control point computation can run without calling into libobs.
+ * Groups are flattened into their children, whose transform is stored in
+ * canvas space so items can be matched across different parents.
+ */
+struct item_snapshot {
+	obs_sceneitem_t           *item;
+	obs_source_t              *source;
+	const item_parent_t       *parent;
+	const char                *name;
+	struct obs_transform_info info;
+	struct obs_sceneitem_crop crop;
+	float                     base_width;
+	float                     base_height;
+	float                     width;
+	float                     height;
+	bool                      visible;
+	bool                      textured;
+};
+
+/*
+ * Per-frame staging for one item: the evaluate pass fills it, the commit
+ * pass pushes it to libobs or draws from it.
+ */
+struct item_state {
+	struct obs_transform_info info;
+	struct obs_sceneitem_crop crop;
+	float                     time;
+	bool                      skip;
+	bool                      culled;
+};
+
+/*
+ * An item's slice of the transition when items are staggered. The slice
+ * and the half its variation plays in are folded into one remap of the
+ * transition time, t * scale + offset clamped to [lo, hi], computed once
+ * per plan.
+ */
+struct item_window {
+	float                     scale;
+	float                     offset;
+	float                     lo;
+	float                     hi;
+};
+
+struct name_index {
+	const char         *name;
+	size_t             idx;
+};
+
+struct list_info {
+	obs_scene_t        *scene;
+	obs_scene_t        *origin;
+	obs_source_t       *source;
+	moving_item_t      *items;
+	item_state_t       *states;
+	item_window_t      *windows;
+	size_t             num_items;
+	item_snapshot_t    *snapshots;
+	name_index_t       *index;
+	size_t             *match;
+	size_t             num_snapshots;
+	size_t             max_snapshots;
+};
+
+struct transition_plan {
+	struct arena       arena;
+	list_info_t        out_list;
+	list_info_t        in_list;
+	float              acc_x;
+	float              acc_y;
+	float              canvas_width;
+	float              canvas_height;
+	float              small_area;
+	enum stagger_mode  stagger;
+	float              stagger_amount;
+	struct vec2        focal;
+	bool               stagger_reverse;
+	bool               direct_render;
+};
+
+void snapshot_scenes(transition_plan_t *plan);
+void snapshot_inflight(transition_plan_t *plan, const list_info_t *from);
+void uncull_items(list_info_t *list);
+bool can_render_direct(transition_plan_t *plan);
+void create_item_list(transition_plan_t *plan);
+void release_plan(transition_plan_t *plan);
+
+void evaluate_items(transition_plan_t *plan, list_info_t *list, float time,
+	enum governor_tier tier, uint32_t frame);
+void commit_items(transition_plan_t *plan, list_info_t *list,
+	enum governor_tier tier, uint64_t *touched, uint64_t *setters);
+void render_items(transition_plan_t *plan, list_info_t *list,
+	uint64_t *touched);
@@ -0,0 +1,727 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+#include "motion-trigger.h"
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define QUEUE_SIZE 256
+#define NO_STEP    ((size_t)-1)
+
+enum request_state {
+	REQUEST_WAITING = 0,
+	REQUEST_DELAYED,
+	REQUEST_TRIGGERED,
+	REQUEST_RUNNING,
+	REQUEST_DONE
+};
+
+/* 'after' and 'with' are only used in sequences */
+struct trigger_request {
+	obs_weak_source_t   *source;
+	motion_trigger_func func;
+	void                *data;
+	float               offset;
+	bool                forward;
+	size_t              after;
+	size_t              with;
+	enum request_state  state;
+	float               delay;
+};
+
+struct trigger_batch {
+	struct trigger_batch *next;
+	uint64_t            submit_ns;
+	bool                sequence;
+	size_t              pending;
+	size_t              count;
+	struct trigger_request requests[];
+};
+
+/*
+ * Bounded multi-producer queue with per-cell sequence numbers: a producer
+ * claims a cell by moving the enqueue position with a compare-and-swap
+ * and publishes it through the cell's sequence, so producers never block
+ * each other or the video thread.
+ */
+struct queue_cell {
+	volatile long        seq;
+	struct trigger_batch *batch;
+};
+
+struct registered_filter {
+	struct registered_filter *next;
+	obs_source_t        *source;
+	motion_trigger_func func;
+	motion_query_func   query;
+	void                *data;
+};
+
+static struct queue_cell cells[QUEUE_SIZE];
+static volatile long enqueue_pos;
+static long dequeue_pos;
+static bool initialized;
+
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct registered_filter *registry;
+
+/* running sequences and plain batches with offsets, video thread only */
+static struct trigger_batch *active;
+static struct motion_stat latency;
+
+static bool submit(struct trigger_batch *batch)
+{
+	long pos = os_atomic_load_long(&enqueue_pos);
+	struct queue_cell *cell;
+
+	batch->submit_ns = os_gettime_ns();
+
+	for (;;) {
+		long diff;
+
+		cell = &cells[(unsigned long)pos & (QUEUE_SIZE - 1)];
+		diff = os_atomic_load_long(&cell->seq) - pos;
+
+		if (diff == 0) {
+			if (os_atomic_compare_swap_long(&enqueue_pos, pos,
+					pos + 1))
+				break;
+			pos = os_atomic_load_long(&enqueue_pos);
+		} else if (diff < 0) {
+			return false;
+		} else {
+			pos = os_atomic_load_long(&enqueue_pos);
+		}
+	}
+
+	/* full barriers on both sides, so the batch is visible first */
+	cell->batch = batch;
+	os_atomic_inc_long(&cell->seq);
+	return true;
+}
+
+/* video thread only */
+static struct trigger_batch *take(void)
+{
+	struct queue_cell *cell = &cells[(unsigned long)dequeue_pos &
+		(QUEUE_SIZE - 1)];
+	struct trigger_batch *batch;
+
+	if (os_atomic_load_long(&cell->seq) != dequeue_pos + 1)
+		return NULL;
+
+	batch = cell->batch;
+	os_atomic_compare_swap_long(&cell->seq, dequeue_pos + 1,
+		dequeue_pos + QUEUE_SIZE);
+	dequeue_pos++;
+	return batch;
+}
+
+static void free_batch(struct trigger_batch *batch)
+{
+	for (size_t i = 0; i < batch->count; i++)
+		obs_weak_source_release(batch->requests[i].source);
+	bfree(batch);
+}
+
+static void start_step(struct trigger_batch *batch, size_t idx);
+
+/* schedules the steps waiting on 'idx' to start, or to finish */
+static void release_steps(struct trigger_batch *batch, size_t idx,
+	bool finished)
+{
+	for (size_t i = 0; i < batch->count; i++) {
+		struct trigger_request *req = &batch->requests[i];
+
+		if (req->state != REQUEST_WAITING ||
+				(finished ? req->after : req->with) != idx)
+			continue;
+
+		if (req->offset > 0.0f) {
+			req->state = REQUEST_DELAYED;
+			req->delay = req->offset;
+		} else {
+			start_step(batch, i);
+		}
+	}
+}
+
+/* a step that never ran releases its 'with' steps along with the rest */
+static void end_step(struct trigger_batch *batch, size_t idx, bool ran)
+{
+	batch->requests[idx].state = REQUEST_DONE;
+	batch->pending--;
+
+	if (!ran)
+		release_steps(batch, idx, false);
+	release_steps(batch, idx, true);
+}
+
+/*
+ * The filter reports the outcome through motion_trigger_notify from
+ * inside the call; one that is gone or stays silent counts as refused.
+ */
+static void start_step(struct trigger_batch *batch, size_t idx)
+{
+	struct trigger_request *req = &batch->requests[idx];
+	obs_source_t *source = obs_weak_source_get_source(req->source);
+
+	req->state = REQUEST_TRIGGERED;
+	if (source) {
+		req->func(req->data, req->forward);
+		obs_source_release(source);
+	}
+
+	if (req->state == REQUEST_TRIGGERED)
+		end_step(batch, idx, false);
+}
+
+static void start_sequence(struct trigger_batch *batch)
+{
+	batch->pending = batch->count;
+	batch->next = active;
+	active = batch;
+
+	for (size_t i = 0; i < batch->count; i++) {
+		struct trigger_request *req = &batch->requests[i];
+
+		if (req->state != REQUEST_WAITING || req->after != NO_STEP ||
+				req->with != NO_STEP)
+			continue;
+
+		if (req->offset > 0.0f) {
+			req->state = REQUEST_DELAYED;
+			req->delay = req->offset;
+		} else {
+			start_step(batch, i);
+		}
+	}
+}
+
+/* plain entries run without reporting back */
+static void fire_request(struct trigger_request *req)
+{
+	obs_source_t *source = obs_weak_source_get_source(req->source);
+
+	req->state = REQUEST_DONE;
+
+	/* a filter removed since submission is skipped */
+	if (source) {
+		req->func(req->data, req->forward);
+		obs_source_release(source);
+	}
+}
+
+/*
+ * Entries without an offset start right away. The others wait in the
+ * active list like sequence steps, each request counted down on its own.
+ */
+static void start_plain(struct trigger_batch *batch)
+{
+	for (size_t i = 0; i < batch->count; i++) {
+		struct trigger_request *req = &batch->requests[i];
+
+		if (req->offset > 0.0f) {
+			req->state = REQUEST_DELAYED;
+			req->delay = req->offset;
+			batch->pending++;
+		} else {
+			fire_request(req);
+		}
+	}
+
+	if (batch->pending) {
+		batch->next = active;
+		active = batch;
+	} else {
+		free_batch(batch);
+	}
+}
+
+static bool source_exists(obs_weak_source_t *weak)
+{
+	obs_source_t *source = obs_weak_source_get_source(weak);
+	obs_source_release(source);
+	return source != NULL;
+}
+
+/*
+ * Counts down delayed entries, each one firing on the frame nearest to its
+ * time, and ends sequence steps whose filter went away mid-motion.
+ */
+static void tick_batches(float seconds)
+{
+	struct trigger_batch **prev = &active;
+	struct trigger_batch *batch;
+
+	while ((batch = *prev) != NULL) {
+		for (size_t i = 0; i < batch->count; i++) {
+			struct trigger_request *req = &batch->requests[i];
+
+			if (req->state == REQUEST_DELAYED) {
+				req->delay -= seconds;
+				if (req->delay >= seconds * 0.5f)
+					continue;
+
+				if (batch->sequence) {
+					start_step(batch, i);
+				} else {
+					fire_request(req);
+					batch->pending--;
+				}
+			} else if (req->state == REQUEST_RUNNING &&
+					!source_exists(req->source)) {
+				end_step(batch, i, true);
+			}
+		}
+
+		if (!batch->pending) {
+			*prev = batch->next;
+			free_batch(batch);
+		} else {
+			prev = &batch->next;
+		}
+	}
+}
+
+/*
+ * Batches already waiting are advanced first, so delays started on an
+ * earlier frame count this one and a new batch's delays do not, whether
+ * they belong to a sequence or not.
+ */
+static void run_batches(void *param, float seconds)
+{
+	struct trigger_batch *batch;
+
+	tick_batches(seconds);
+
+	while ((batch = take()) != NULL) {
+		motion_stat_record(&latency, os_gettime_ns() - batch->submit_ns);
+
+		if (batch->sequence)
+			start_sequence(batch);
+		else
+			start_plain(batch);
+	}
+
+	UNUSED_PARAMETER(param);
+}
+
+void motion_trigger_notify(obs_source_t *source, enum motion_event event)
+{
+	enum request_state state = event == MOTION_FINISHED ?
+		REQUEST_RUNNING : REQUEST_TRIGGERED;
+
+	for (struct trigger_batch *batch = active; batch;
+			batch = batch->next) {
+		for (size_t i = 0; i < batch->count; i++) {
+			struct trigger_request *req = &batch->requests[i];
+
+			if (req->state != state ||
+					!obs_weak_source_references_source(
+						req->source, source))
+				continue;
+
+			if (event == MOTION_STARTED) {
+				req->state = REQUEST_RUNNING;
+				release_steps(batch, i, false);
+			} else {
+				end_step(batch, i, event == MOTION_FINISHED);
+			}
+			break;
+		}
+	}
+}
+
+static bool find_filter(obs_source_t *source, struct registered_filter *out)
+{
+	struct registered_filter *filter;
+	bool found = false;
+
+	pthread_mutex_lock(&registry_mutex);
+	for (filter = registry; filter; filter = filter->next) {
+		if (filter->source == source) {
+			*out = *filter;
+			found = true;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&registry_mutex);
+
+	return found;
+}
+
+static bool find_filter_by_name(const char *parent_name,
+	const char *filter_name, struct registered_filter *out)
+{
+	obs_source_t *parent = obs_get_source_by_name(parent_name);
+	obs_source_t *source = parent ?
+		obs_source_get_filter_by_name(parent, filter_name) : NULL;
+	bool found = source && find_filter(source, out);
+
+	obs_source_release(source);
+	obs_source_release(parent);
+	return found;
+}
+
+static void set_request(struct trigger_request *req,
+	const struct registered_filter *filter, bool forward, double offset)
+{
+	req->source = obs_source_get_weak_source(filter->source);
+	req->func = filter->func;
+	req->data = filter->data;
+	req->forward = forward;
+	req->offset = offset > 0.0 ? (float)offset : 0.0f;
+	req->after = NO_STEP;
+	req->with = NO_STEP;
+}
+
+static void trigger_proc(void *data, calldata_t *cd)
+{
+	struct registered_filter *filter = data;
+	struct trigger_batch *batch = bzalloc(sizeof(struct trigger_batch) +
+		sizeof(struct trigger_request));
+	double offset = 0.0;
+	bool queued;
+
+	calldata_get_float(cd, "offset", &offset);
+	set_request(&batch->requests[0], filter, calldata_bool(cd, "forward"),
+		offset);
+	batch->count = 1;
+
+	queued = submit(batch);
+	if (!queued)
+		free_batch(batch);
+	calldata_set_bool(cd, "queued", queued);
+}
+
+static size_t find_step(const char **ids, size_t count, const char *id)
+{
+	if (!id || !*id)
+		return NO_STEP;
+
+	for (size_t i = 0; i < count; i++) {
+		if (strcmp(ids[i], id) == 0)
+			return i;
+	}
+	return NO_STEP;
+}
+
+static inline size_t get_parent(const struct trigger_request *req)
+{
+	return req->after != NO_STEP ? req->after : req->with;
+}
+
+/*
+ * Resolves "after" and "with" to entry indices. An entry waits on one
+ * other entry at most, so a cycle shows up as a parent chain longer than
+ * the batch.
+ */
+static bool link_steps(struct trigger_batch *batch,
+	obs_data_array_t *triggers)
+{
+	const char **ids = bzalloc(sizeof(const char *) * batch->count);
+	bool linked = true;
+
+	/* the strings stay owned by the array */
+	for (size_t i = 0; i < batch->count; i++) {
+		obs_data_t *entry = obs_data_array_item(triggers, i);
+		ids[i] = obs_data_get_string(entry, "id");
+		obs_data_release(entry);
+	}
+
+	for (size_t i = 0; linked && i < batch->count; i++) {
+		struct trigger_request *req = &batch->requests[i];
+		obs_data_t *entry = obs_data_array_item(triggers, i);
+		const char *after = obs_data_get_string(entry, "after");
+		const char *with = obs_data_get_string(entry, "with");
+
+		req->after = find_step(ids, batch->count, after);
+		req->with = find_step(ids, batch->count, with);
+
+		if ((*after && *with) || (*after && req->after == NO_STEP) ||
+				(*with && req->with == NO_STEP)) {
+			blog(LOG_WARNING, "[motion-effect] trigger batch: "
+				"entry %zu has an unknown \"after\" or "
+				"\"with\" id, or both", i);
+			linked = false;
+		}
+
+		if (*after || *with)
+			batch->sequence = true;
+		obs_data_release(entry);
+	}
+
+	for (size_t i = 0; linked && i < batch->count; i++) {
+		size_t step = get_parent(&batch->requests[i]);
+		size_t depth = 0;
+
+		while (step != NO_STEP && depth++ <= batch->count)
+			step = get_parent(&batch->requests[step]);
+
+		if (step != NO_STEP) {
+			blog(LOG_WARNING, "[motion-effect] trigger batch: "
+				"entries wait on each other");
+			linked = false;
+		}
+	}
+
+	bfree(ids);
+	return linked;
+}
+
+/* resolves every entry or none */
+static struct trigger_batch *create_batch(obs_data_array_t *triggers)
+{
+	size_t count = obs_data_array_count(triggers);
+	struct trigger_batch *batch = bzalloc(sizeof(struct trigger_batch) +
+		sizeof(struct trigger_request) * count);
+
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *entry = obs_data_array_item(triggers, i);
+		const char *parent_name = obs_data_get_string(entry, "source");
+		const char *filter_name = obs_data_get_string(entry, "filter");
+		struct registered_filter filter;
+		bool found = find_filter_by_name(parent_name, filter_name,
+			&filter);
+
+		if (found) {
+			set_request(&batch->requests[batch->count++], &filter,
+				obs_data_get_bool(entry, "forward"),
+				obs_data_get_double(entry, "offset"));
+		} else {
+			blog(LOG_WARNING, "[motion-effect] trigger batch: no "
+				"motion filter '%s' on '%s'", filter_name,
+				parent_name);
+		}
+
+		obs_data_release(entry);
+
+		if (!found) {
+			free_batch(batch);
+			return NULL;
+		}
+	}
+
+	if (!link_steps(batch, triggers)) {
+		free_batch(batch);
+		return NULL;
+	}
+
+	return batch;
+}
+
+static void trigger_batch_proc(void *data, calldata_t *cd)
+{
+	const char *json = NULL;
+	obs_data_t *root = NULL;
+	obs_data_array_t *triggers = NULL;
+	struct trigger_batch *batch = NULL;
+	bool queued = false;
+
+	if (calldata_get_string(cd, "json", &json) && json)
+		root = obs_data_create_from_json(json);
+	if (root)
+		triggers = obs_data_get_array(root, "triggers");
+	if (triggers && obs_data_array_count(triggers))
+		batch = create_batch(triggers);
+
+	if (batch) {
+		queued = submit(batch);
+		if (!queued) {
+			blog(LOG_WARNING, "[motion-effect] trigger queue full, "
+				"batch dropped");
+			free_batch(batch);
+		}
+	}
+
+	calldata_set_bool(cd, "queued", queued);
+	obs_data_array_release(triggers);
+	obs_data_release(root);
+	UNUSED_PARAMETER(data);
+}
+
+bool motion_trigger_submit(const struct motion_trigger_entry *entries,
+	size_t count)
+{
+	struct trigger_batch *batch;
+
+	if (!count)
+		return false;
+
+	batch = bzalloc(sizeof(struct trigger_batch) +
+		sizeof(struct trigger_request) * count);
+
+	for (size_t i = 0; i < count; i++) {
+		const struct motion_trigger_entry *entry = &entries[i];
+		struct registered_filter filter;
+
+		if (!find_filter_by_name(entry->source, entry->filter,
+				&filter)) {
+			free_batch(batch);
+			return false;
+		}
+
+		set_request(&batch->requests[batch->count++], &filter,
+			entry->forward, entry->offset);
+	}
+
+	if (!submit(batch)) {
+		free_batch(batch);
+		return false;
+	}
+	return true;
+}
+
+bool motion_trigger_defer(obs_source_t *source, motion_trigger_func func,
+	void *data, bool forward)
+{
+	struct trigger_batch *batch = bzalloc(sizeof(struct trigger_batch) +
+		sizeof(struct trigger_request));
+	struct trigger_request *req = &batch->requests[0];
+
+	req->source = obs_source_get_weak_source(source);
+	req->func = func;
+	req->data = data;
+	req->forward = forward;
+	req->after = NO_STEP;
+	req->with = NO_STEP;
+	batch->count = 1;
+
+	if (!submit(batch)) {
+		free_batch(batch);
+		return false;
+	}
+	return true;
+}
+
+/* the registry lock keeps the filter alive while it is read */
+bool motion_trigger_query(const char *source, const char *filter,
+	struct motion_trigger_state *state)
+{
+	obs_source_t *parent = obs_get_source_by_name(source);
+	obs_source_t *context = parent ?
+		obs_source_get_filter_by_name(parent, filter) : NULL;
+	struct registered_filter *reg;
+	bool found = false;
+
+	pthread_mutex_lock(&registry_mutex);
+	for (reg = context ? registry : NULL; reg; reg = reg->next) {
+		if (reg->source == context) {
+			memset(state, 0, sizeof(*state));
+			reg->query(reg->data, state);
+			found = true;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&registry_mutex);
+
+	obs_source_release(context);
+	obs_source_release(parent);
+	return found;
+}
+
+void motion_trigger_enum(motion_trigger_enum_func func, void *param)
+{
+	struct registered_filter *reg;
+
+	pthread_mutex_lock(&registry_mutex);
+	for (reg = registry; reg; reg = reg->next)
+		func(param, obs_filter_get_parent(reg->source), reg->source);
+	pthread_mutex_unlock(&registry_mutex);
+}
+
+void motion_trigger_get_latency(struct motion_stat_summary *summary)
+{
+	motion_stat_read(&latency, summary);
+}
+
+void motion_trigger_add_filter(obs_source_t *source,
+	motion_trigger_func func, motion_query_func query, void *data)
+{
+	struct registered_filter *filter = bzalloc(sizeof(*filter));
+	proc_handler_t *ph = obs_source_get_proc_handler(source);
+
+	filter->source = source;
+	filter->func = func;
+	filter->query = query;
+	filter->data = data;
+
+	pthread_mutex_lock(&registry_mutex);
+	filter->next = registry;
+	registry = filter;
+	pthread_mutex_unlock(&registry_mutex);
+
+	proc_handler_add(ph, "void trigger(bool forward, float offset, "
+		"out bool queued)", trigger_proc, filter);
+}
+
+void motion_trigger_remove_filter(void *data)
+{
+	struct registered_filter **prev = &registry;
+	struct registered_filter *filter = NULL;
+
+	pthread_mutex_lock(&registry_mutex);
+	for (; *prev; prev = &(*prev)->next) {
+		if ((*prev)->data == data) {
+			filter = *prev;
+			*prev = filter->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&registry_mutex);
+
+	bfree(filter);
+}
+
+void motion_trigger_init(void)
+{
+	if (initialized)
+		return;
+
+	for (long i = 0; i < QUEUE_SIZE; i++)
+		cells[i].seq = i;
+	enqueue_pos = 0;
+	dequeue_pos = 0;
+
+	obs_add_tick_callback(run_batches, NULL);
+	proc_handler_add(obs_get_proc_handler(),
+		"void motion_trigger_batch(in string json, out bool queued)",
+		trigger_batch_proc, NULL);
+	initialized = true;
+}
+
+void motion_trigger_free(void)
+{
+	struct trigger_batch *batch;
+
+	if (!initialized)
+		return;
+
+	obs_remove_tick_callback(run_batches, NULL);
+	while ((batch = take()) != NULL)
+		free_batch(batch);
+	while ((batch = active) != NULL) {
+		active = batch->next;
+		free_batch(batch);
+	}
+	initialized = false;
+}
@@ -0,0 +1,112 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+
+#pragma once
+
+#include <obs-module.h>
+#include "motion-stats.h"
+
+/*
+ * Triggers from outside the hotkey system. Each motion filter gets a
+ * 'trigger' proc, and the module adds a global 'motion_trigger_batch' proc
+ * that starts several filters at once:
+ *
+ *   void motion_trigger_batch(in string json, out bool queued)
+ *
+ *   {"triggers": [{"source": "<scene>", "filter": "<filter name>",
+ *                  "forward": true, "offset": 0.25}, ...]}
+ *
+ * A batch is resolved on the calling thread and submitted as one entry to
+ * a lock-free queue, which a tick callback drains on the video thread
+ * before sources tick, so every motion in it starts on the same frame.
+ * 'offset' delays a motion by that many seconds of frame time, counted
+ * down here for each entry on its own.
+ *
+ * Entries can also form a sequence: an entry with an "id" can be named by
+ * another entry's "after" (start when it finishes) or "with" (start when
+ * it starts), and 'offset' then counts from that moment. Filters report
+ * their motions starting and finishing from their tick, and dependent
+ * motions are started right there, on the frame the event happens.
+ *
+ *   {"triggers": [{"id": "a", "source": "Scene", "filter": "Slide A"},
+ *                 {"id": "b", ..., "after": "a"},
+ *                 {..., "after": "b", "offset": 0.2}]}
+ */
+
+typedef void (*motion_trigger_func)(void *data, bool forward);
+
+/* 'progress' runs 0 to 1 over a motion and rests at 0 or 1 between them */
+struct motion_trigger_state {
+	bool                running;
+	bool                at_end;
+	float               progress;
+};
+
+typedef void (*motion_query_func)(void *data,
+	struct motion_trigger_state *state);
+
+/* names are those of the batch JSON: the filter's parent, and the filter */
+struct motion_trigger_entry {
+	const char          *source;
+	const char          *filter;
+	bool                forward;
+	float               offset;
+};
+
+typedef void (*motion_trigger_enum_func)(void *param, obs_source_t *parent,
+	obs_source_t *filter);
+
+enum motion_event {
+	MOTION_STARTED,
+	MOTION_REFUSED,
+	MOTION_FINISHED
+};
+
+void motion_trigger_init(void);
+void motion_trigger_free(void);
+
+void motion_trigger_add_filter(obs_source_t *source,
+	motion_trigger_func func, motion_query_func query, void *data);
+void motion_trigger_remove_filter(void *data);
+
+/*
+ * The same path as the procs, for other front ends: submit() queues the
+ * entries as one batch, query() reads a filter's state and enum() lists
+ * the registered filters. Submit-to-frame latency of every batch is kept
+ * in one series.
+ */
+bool motion_trigger_submit(const struct motion_trigger_entry *entries,
+	size_t count);
+bool motion_trigger_query(const char *source, const char *filter,
+	struct motion_trigger_state *state);
+void motion_trigger_enum(motion_trigger_enum_func func, void *param);
+void motion_trigger_get_latency(struct motion_stat_summary *summary);
+
+/*
+ * Runs 'func' for 'source' on the video thread, on the next frame, for
+ * hotkeys, buttons and frontend events, which arrive on threads of their
+ * own while motions may be evaluating on the pool.
+ */
+bool motion_trigger_defer(obs_source_t *source, motion_trigger_func func,
+	void *data, bool forward);
+
+/* video thread only */
+void motion_trigger_notify(obs_source_t *source, enum motion_event event);
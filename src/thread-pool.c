@@ -0,0 +1,175 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#include "thread-pool.h"
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define MAX_WORKERS 8
+
+struct pool_job {
+	thread_pool_task_t  task;
+	void                *param;
+	size_t              count;
+	size_t              chunk_size;
+	long                num_chunks;
+	volatile long       next_chunk;
+	volatile long       running_workers;
+};
+
+struct thread_pool {
+	pthread_t           threads[MAX_WORKERS];
+	int                 num_threads;
+	os_sem_t            *wake;
+	os_event_t          *done;
+	pthread_mutex_t     busy;
+	struct pool_job     job;
+	volatile bool       stop;
+};
+
+static struct thread_pool pool;
+static bool pool_started = false;
+
+static void run_chunks(struct pool_job *job)
+{
+	long idx;
+
+	while ((idx = os_atomic_inc_long(&job->next_chunk) - 1) <
+			job->num_chunks) {
+		size_t start = (size_t)idx * job->chunk_size;
+		size_t end = start + job->chunk_size;
+		if (end > job->count)
+			end = job->count;
+		job->task(job->param, start, end);
+	}
+}
+
+static void *worker_thread(void *data)
+{
+	UNUSED_PARAMETER(data);
+	os_set_thread_name("motion-effect: worker");
+
+	while (os_sem_wait(pool.wake) == 0) {
+		if (os_atomic_load_bool(&pool.stop))
+			break;
+
+		run_chunks(&pool.job);
+
+		if (os_atomic_dec_long(&pool.job.running_workers) == 0)
+			os_event_signal(pool.done);
+	}
+
+	return NULL;
+}
+
+void thread_pool_init(void)
+{
+	int cores = os_get_logical_cores();
+	int workers = cores - 1;
+
+	if (pool_started)
+		return;
+
+	if (workers > MAX_WORKERS)
+		workers = MAX_WORKERS;
+	if (workers <= 0)
+		return;
+
+	memset(&pool, 0, sizeof(pool));
+
+	if (os_sem_init(&pool.wake, 0) != 0)
+		return;
+	if (os_event_init(&pool.done, OS_EVENT_TYPE_AUTO) != 0) {
+		os_sem_destroy(pool.wake);
+		return;
+	}
+	pthread_mutex_init(&pool.busy, NULL);
+
+	for (int i = 0; i < workers; i++) {
+		if (pthread_create(&pool.threads[i], NULL, worker_thread,
+			NULL) != 0)
+			break;
+		pool.num_threads++;
+	}
+
+	pool_started = true;
+	blog(LOG_INFO, "[motion-effect] started %d worker thread(s)",
+		pool.num_threads);
+}
+
+void thread_pool_free(void)
+{
+	if (!pool_started)
+		return;
+
+	os_atomic_set_bool(&pool.stop, true);
+	for (int i = 0; i < pool.num_threads; i++)
+		os_sem_post(pool.wake);
+	for (int i = 0; i < pool.num_threads; i++)
+		pthread_join(pool.threads[i], NULL);
+
+	pthread_mutex_destroy(&pool.busy);
+	os_event_destroy(pool.done);
+	os_sem_destroy(pool.wake);
+	pool_started = false;
+}
+
+void thread_pool_run(size_t count, size_t chunk_size, thread_pool_task_t task,
+	void *param)
+{
+	struct pool_job *job = &pool.job;
+	long num_chunks;
+	long workers;
+
+	if (!count)
+		return;
+	if (!chunk_size)
+		chunk_size = 1;
+
+	num_chunks = (long)((count + chunk_size - 1) / chunk_size);
+
+	if (!pool_started || num_chunks < 2 ||
+			pthread_mutex_trylock(&pool.busy) != 0) {
+		task(param, 0, count);
+		return;
+	}
+
+	workers = num_chunks - 1;
+	if (workers > pool.num_threads)
+		workers = pool.num_threads;
+
+	job->task = task;
+	job->param = param;
+	job->count = count;
+	job->chunk_size = chunk_size;
+	job->num_chunks = num_chunks;
+	os_atomic_set_long(&job->next_chunk, 0);
+	os_atomic_set_long(&job->running_workers, workers);
+
+	for (long i = 0; i < workers; i++)
+		os_sem_post(pool.wake);
+
+	run_chunks(job);
+
+	if (workers > 0)
+		os_event_wait(pool.done);
+
+	pthread_mutex_unlock(&pool.busy);
+}
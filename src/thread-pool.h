@@ -0,0 +1,38 @@
+/*
+*	motion-effect, an OBS-Studio plugin for animating sources using
+*	transform manipulation on the scene.
+*	Copyright(C) <2018>  <CatxFish>
+*
+*	This program is free software; you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation; either version 2 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License along
+*	with this program; if not, write to the Free Software Foundation, Inc.,
+*	51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301 USA.
+*/
+
+#pragma once
+
+#include <obs-module.h>
+
+/*
+ * Small module-wide worker pool. thread_pool_run() splits [0, count) into
+ * chunks of chunk_size and runs them on the workers and the calling thread,
+ * returning once every chunk is done. If the pool is busy or was never
+ * started, the whole range runs on the calling thread.
+ */
+
+typedef void (*thread_pool_task_t)(void *param, size_t start, size_t end);
+
+void thread_pool_init(void);
+void thread_pool_free(void);
+
+void thread_pool_run(size_t count, size_t chunk_size, thread_pool_task_t task,
+	void *param);